@@ -13,56 +13,291 @@
 #include "ADCVar.h"
 
 /**
- * @brief Initializes ADC0 peripheral with burst averaging and timing settings.
+ * @brief Conversion sequence of the background acquisition.
+ *
+ * Each entry selects the input and the reference used for it. The ADC interrupt stores
+ * the result of the finished step and prepares the next one; the conversion itself is
+ * started by the TCA0 overflow event.
+ */
+static const ADC_SEQUENCE_STEP adc_sequence[ADC_SEQ_COUNT] = {
+	[ADC_SEQ_VOLTAGE] = { .MuxPos = Voltage,                .RefSel = ADC_REFSEL_2048MV_gc }, ///< AMC1311 output, fixed 2.048V reference
+	[ADC_SEQ_CURRENT] = { .MuxPos = Current,                .RefSel = ADC_REFSEL_VDD_gc },    ///< TMCS1100 output, ratiometric to VDD
+	[ADC_SEQ_VDD]     = { .MuxPos = ADC_MUXPOS_VDDDIV10_gc, .RefSel = ADC_REFSEL_1024MV_gc }  ///< VDD/10 for current scaling
+};
+
+/**
+ * @brief Acquisition profiles per sequence step, indexed by adcProfile_t.
+ *
+ * VDD has a single profile, used for both entries.
+ */
+static const ADC_PROFILE adc_profiles[ADC_SEQ_COUNT][ADC_PROFILES] = {
+	[ADC_SEQ_VOLTAGE] = {
+		[ADC_PROFILE_DEEP] = { .Shift = ADC_DEEP_SHIFT, .SampDur = ADC_DEEP_SAMPDUR, .Presc = ADC_DEEP_PRESC, .Pga = ADC_VOLTAGE_PGA },
+		[ADC_PROFILE_FAST] = { .Shift = ADC_FAST_SHIFT, .SampDur = ADC_FAST_SAMPDUR, .Presc = ADC_FAST_PRESC, .Pga = ADC_VOLTAGE_PGA }
+	},
+	[ADC_SEQ_CURRENT] = {
+		[ADC_PROFILE_DEEP] = { .Shift = ADC_DEEP_SHIFT, .SampDur = ADC_DEEP_SAMPDUR, .Presc = ADC_DEEP_PRESC, .Pga = ADC_CURRENT_PGA },
+		[ADC_PROFILE_FAST] = { .Shift = ADC_FAST_SHIFT, .SampDur = ADC_FAST_SAMPDUR, .Presc = ADC_FAST_PRESC, .Pga = ADC_CURRENT_PGA }
+	},
+	[ADC_SEQ_VDD] = {
+		[ADC_PROFILE_DEEP] = { .Shift = ADC_VDD_SHIFT, .SampDur = ADC_VDD_SAMPDUR, .Presc = ADC_VDD_PRESC, .Pga = 0 },
+		[ADC_PROFILE_FAST] = { .Shift = ADC_VDD_SHIFT, .SampDur = ADC_VDD_SAMPDUR, .Presc = ADC_VDD_PRESC, .Pga = 0 }
+	}
+};
+
+/*
+ * Figures of the profile table in ADC.h: update the table when a profile changes.
+ */
+_Static_assert((1 << ADC_FAST_SHIFT) == 16 && ADC_FAST_US == 120 && ADC_EFFECTIVE_BITS_X2(ADC_FAST_SHIFT) == 2 * 14,
+	"ADC.h profile table: fast profile");
+_Static_assert((1 << ADC_DEEP_SHIFT) == 1024 && ADC_DEEP_US == 7680 && ADC_EFFECTIVE_BITS_X2(ADC_DEEP_SHIFT) == 2 * 17,
+	"ADC.h profile table: deep profile");
+_Static_assert((1 << ADC_VDD_SHIFT) == 256 && ADC_VDD_US == 1920 && ADC_EFFECTIVE_BITS_X2(ADC_VDD_SHIFT) == 2 * 16,
+	"ADC.h profile table: VDD profile");
+
+/*
+ * Scaling multipliers: rounding error against the exact ratio and 32-bit headroom for
+ * 12-bit samples with the largest calibration gain (just below 2).
+ */
+#define ADC_COEF_WITHIN(mul, num, den, shift) \
+	((uint64_t)(mul) * (den) > ((uint64_t)(num) << (shift)) \
+		? (uint64_t)(mul) * (den) - ((uint64_t)(num) << (shift)) <= ((uint64_t)(num) << (shift)) * ADC_COEF_MAX_PPM / 1000000 \
+		: ((uint64_t)(num) << (shift)) - (uint64_t)(mul) * (den) <= ((uint64_t)(num) << (shift)) * ADC_COEF_MAX_PPM / 1000000)
+_Static_assert(ADC_COEF_WITHIN(AMC1311_COEF_MUL, AMC1311_REF_MV * AMC1311_INPUT_FS_V * VOLTAGE_UNITS_PER_V,
+	ADC_FULL_SCALE * AMC1311_INPUT_FS_MV, AMC1311_COEF_SHIFT), "AMC1311_COEF_MUL too coarse: raise AMC1311_COEF_SHIFT");
+_Static_assert((uint64_t)(ADC_FULL_SCALE - 1) * AMC1311_COEF_MUL * 2 <= UINT32_MAX,
+	"Voltage product overflows: lower AMC1311_COEF_SHIFT");
+_Static_assert(ADC_COEF_WITHIN(TMCS1100_COEF_MUL, VDD_DIVIDER * VDD_REF_MV * CURRENT_UNITS_PER_A,
+	(uint64_t)ADC_FULL_SCALE * ADC_FULL_SCALE * TMCS1100_SENSITIVITY_MV_A, TMCS1100_COEF_SHIFT + TMCS1100_VDD_SHIFT),
+	"TMCS1100_COEF_MUL too coarse: raise TMCS1100_COEF_SHIFT");
+_Static_assert((uint64_t)(ADC_FULL_SCALE - 1) * TMCS1100_COEF_MUL * 2 <= UINT32_MAX,
+	"VDD product overflows: lower TMCS1100_COEF_SHIFT");
+_Static_assert((uint64_t)(ADC_FULL_SCALE - 1) * (((uint64_t)(ADC_FULL_SCALE - 1) * TMCS1100_COEF_MUL * 2) >> TMCS1100_VDD_SHIFT) <= UINT32_MAX,
+	"Current product overflows: raise TMCS1100_VDD_SHIFT");
+
+/**
+ * @brief Returns the profile currently selected for a sequence step.
+ */
+static const ADC_PROFILE *ADC0_Profile(uint8_t step) {
+	return &adc_profiles[step][ADCAcquisition.Profile[step]];
+}
+
+/**
+ * @brief Selects input, reference and acquisition profile for a sequence step.
+ *
+ * @param step Sequence step to prepare.
+ */
+static void ADC0_SelectStep(uint8_t step) {
+	const ADC_PROFILE *profile = ADC0_Profile(step);
+
+	ADC0.MUXPOS = adc_sequence[step].MuxPos | (profile->Pga ? ADC_VIA_PGA_gc : ADC_VIA_ADC_gc);
+	ADC0.CTRLC = (ADC0.CTRLC & ~ADC_REFSEL_gm) | adc_sequence[step].RefSel;
+	ADC0.CTRLB = profile->Presc;
+	ADC0.CTRLE = profile->SampDur;
+	ADC0.CTRLF = profile->Shift << ADC_SAMPNUM_gp;
+	ADC0.PGACTRL = profile->Pga;
+}
+
+/**
+ * @brief Reads the accumulated burst and scales it back to one 12-bit sample.
+ *
+ * @param profile Profile the burst was taken with.
+ * @return Rounded mean of the burst, divided by the PGA gain.
+ */
+static uint16_t ADC0_BurstSample(const ADC_PROFILE *profile) {
+	uint8_t shift = profile->Shift;
+
+	if (profile->Pga) {
+		shift += (profile->Pga & ADC_GAIN_gm) >> ADC_GAIN_gp; // Gain is 2^n
+	}
+	return (ADC0.RESULT + ((1UL << shift) >> 1)) >> shift;
+}
+
+/**
+ * @brief Picks the profile for the next burst of a voltage or current step.
+ *
+ * @param step Finished step.
+ * @param sample New sample; compared with the previous one of the same step.
+ */
+static void ADC0_Adapt(uint8_t step, uint16_t sample) {
+	uint16_t previous = ADCAcquisition.Sample[step];
+	uint16_t change = sample > previous ? sample - previous : previous - sample;
+
+	if (change > ADC_MOVING_THRESHOLD) {
+		ADCAcquisition.Profile[step] = ADC_PROFILE_FAST;
+		ADCAcquisition.Steady[step] = 0;
+	}
+	else if (ADCAcquisition.Steady[step] < ADC_STEADY_ROUNDS && ++ADCAcquisition.Steady[step] == ADC_STEADY_ROUNDS) {
+		ADCAcquisition.Profile[step] = ADC_PROFILE_DEEP;
+	}
+}
+
+/**
+ * @brief Initializes ADC0 peripheral with burst averaging and starts background acquisition.
  *
  * - Enables the ADC.
- * - Sets the ADC clock prescaler.
  * - Applies timebase for proper sampling setup.
- * - Uses 1024-sample accumulation for noise reduction.
- * - Configures burst mode.
+ * - Selects the first step; prescaler, sample duration, accumulation and PGA come
+ *   from the step's acquisition profile.
+ * - Configures burst mode (plain accumulation) started by an event.
+ * - Routes the TCA0 overflow through event channel 0 to the ADC start input, so a
+ *   conversion starts every ADC_TRIGGER_PERIOD_MS without CPU involvement.
  */
 void ADC0_init() {
 	ADC0.CTRLA = ADC_ENABLE_bm; ///< Enable ADC
-	ADC0.CTRLB = ADC_PRESC_DIV10_gc; ///< Set ADC clock prescaler to divide by 10
 	ADC0.CTRLC = (TIMEBASE_VALUE << ADC_TIMEBASE_gp); ///< Set ADC timebase
-	ADC0.CTRLE = 0; ///< Set sampling length to 0.5 ADC cycles
-	ADC0.CTRLF = ADC_SAMPNUM_ACC1024_gc; ///< Accumulate 1024 samples for each result
-	ADC0.COMMAND = ADC_MODE_BURST_SCALING_gc; ///< Use burst mode for better averaging
-	while (ADC0.STATUS & ADC_ADCBUSY_bm); ///< Wait until ADC is ready
+	ADC0_SelectStep(ADCAcquisition.Step); ///< First input, reference and profile
+	ADC0.INTCTRL = ADC_RESRDY_bm; ///< Interrupt when the burst is complete
+	ADC0.COMMAND = ADC_MODE_BURST_gc | ADC_START_EVENT_TRIGGER_gc; ///< Burst mode (full sum in RESULT), started by event
+
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc; ///< TCA0 overflow drives event channel 0
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc; ///< Event channel 0 starts ADC0
+
+	TCA0.SINGLE.PER = ADC_TCA_TOP; ///< Conversion trigger period
+	TCA0.SINGLE.CTRLB = TCA_SINGLE_WGMODE_NORMAL_gc;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV64_gc | TCA_SINGLE_ENABLE_bm; ///< CLK_PER / 64, start
 }
 
 /**
- * @brief Performs a single ADC read on the specified channel.
+ * @brief Returns the latest raw ADC result of a sequence step.
  *
- * Starts a conversion and waits for completion. Returns the average result of 1024 samples.
+ * Never waits for the ADC; the value is at most ADC_SEQ_COUNT trigger periods old.
  *
- * @param channel The ADC multiplexer positive input channel.
- * @return 16-bit averaged ADC result.
+ * @param step Sequence step (adcSequence_t).
+ * @return Last 12-bit sample of that input.
  */
-uint16_t ADC0_Read(uint8_t channel) {
-	ADC0.MUXPOS = channel;
-	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc; ///< Start conversion
-	while (ADC0.STATUS & ADC_ADCBUSY_bm); ///< Wait for ADC to become ready
-	while (!(ADC0.INTFLAGS & ADC_SAMPRDY_bm)); ///< Wait until the result is ready
-	ADC0.INTFLAGS = ADC_SAMPRDY_bm; ///< Clear the sample ready flag
-	return ADC0.SAMPLE; ///< Return averaged result
+uint16_t ADC0_Latest(uint8_t step) {
+	uint16_t sample;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		sample = ADCAcquisition.Sample[step];
+	}
+	return sample;
 }
 
-void ReadSolarCells(solarrcells_t channel) {
-	ADC_VALUES *voltageORcurrent = (channel == Voltage) ? &ReadVoltage : &ReadCurrent;
+/**
+ * @brief Returns the time since the last VDD measurement.
+ *
+ * @return Age of VddTracker in milliseconds (scheduler ticks).
+ */
+uint16_t ADC0_VddAge() {
+	uint16_t timestamp;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		timestamp = VddTracker.Timestamp;
+	}
+	return Scheduler_Millis() - timestamp;
+}
+
+/**
+ * @brief Picks the sequence step that follows a finished step.
+ *
+ * Voltage and current alternate; after every VDD_MEASURE_ROUNDS current steps one
+ * VDD step is inserted.
+ *
+ * @param step Finished step.
+ * @return Next step.
+ */
+static uint8_t ADC0_NextStep(uint8_t step) {
+	if (step == ADC_SEQ_VOLTAGE) {
+		return ADC_SEQ_CURRENT;
+	}
+	if (step == ADC_SEQ_CURRENT && --ADCAcquisition.VddCountdown == 0) {
+		ADCAcquisition.VddCountdown = VDD_MEASURE_ROUNDS;
+		return ADC_SEQ_VDD;
+	}
+	return ADC_SEQ_VOLTAGE;
+}
 
+/**
+ * @brief Feeds a VDD/10 sample into the VDD tracker (called from the ADC interrupt).
+ *
+ * @param sample New VDD/10 sample.
+ */
+static void ADC0_TrackVdd(uint16_t sample) {
+	if (VddTracker.Valid) {
+		VddTracker.Filtered += sample - (VddTracker.Filtered >> VDD_FILTER_SHIFT); // First-order low-pass
+	}
+	else {
+		VddTracker.Filtered = sample << VDD_FILTER_SHIFT; // Start from the first measurement
+		VddTracker.Valid = 1;
+	}
+	VddTracker.Sample = VddTracker.Filtered >> VDD_FILTER_SHIFT; // Settles exactly on a constant input
+	VddTracker.CurrentCoef = ((uint32_t)VddTracker.Sample * Calibration.CurrentMul) >> TMCS1100_VDD_SHIFT;
+	VddTracker.Timestamp = SchedulerTicks;
+}
+
+/**
+ * @brief Scales a raw current sample with the tracked VDD.
+ *
+ * @param sample 12-bit current sample.
+ * @return |I - zero offset| in 0.01A (zero offset from the calibration, default 0,125A).
+ */
+uint16_t ADC0_ScaleCurrent(uint16_t sample) {
+	// Current measurement depends on MCU VDD; the tracked VDD provides the scaling factor.
+	uint32_t coef;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		coef = VddTracker.CurrentCoef;
+	}
+	uint32_t scaled = sample * coef;
+	uint16_t current = scaled >> TMCS1100_COEF_SHIFT; ///< Current rounded down, 0.01A
+	uint16_t zero = Calibration.CurrentZero;
+	if (current >= zero) {
+		return current - zero; // -0,125A by default
+	}
+	// Below the sensor zero offset: |I - zero| with the current rounded up
+	return zero - ((scaled + (1UL << TMCS1100_COEF_SHIFT) - 1) >> TMCS1100_COEF_SHIFT);
+}
+
+/**
+ * @brief Scales a raw voltage sample with the calibrated gain and offset.
+ *
+ * @param sample 12-bit voltage sample.
+ * @return Voltage in 0.1V (not below 0).
+ */
+uint16_t ADC0_ScaleVoltage(uint16_t sample) {
+	// Voltage measurement uses a fixed 2.048V reference, independent of VDD.
+	int32_t voltage = (int32_t)(((uint32_t)sample * Calibration.VoltageMul) >> AMC1311_COEF_SHIFT) + Calibration.VoltageOffset;
+	return voltage > 0 ? voltage : 0;
+}
+
+/**
+ * @brief Converts the latest raw samples of a solar cell channel into its result.
+ *
+ * @param channel Voltage or Current.
+ */
+void ReadSolarCells(solarrcells_t channel) {
 	if (channel == Current) {
-		// Current measurement depends on MCU VDD; we need to measure VDD to calibrate range.
-		ADC0.CTRLC = (ADC0.CTRLC & ~ADC_REFSEL_gm) | ADC_REFSEL_1024MV_gc;
-		float mcuVoltage = 0.25 * ADC0_Read(ADC_MUXPOS_VDDDIV10_gc); ///< VDD = 10  ADC result  1.024 / 4096
-		float koef = mcuVoltage / 409.6;
-		ADC0.CTRLC = (ADC0.CTRLC & ~ADC_REFSEL_gm) | ADC_REFSEL_VDD_gc;
-		uint16_t current = abs((ADC0_Read(channel)*koef/4)-12); //-0,125A
-		voltageORcurrent->Result = current /*> TMCS1100_ZERO_I ? current - TMCS1100_ZERO_I : current*/;
+		ReadCurrent.Result = ADC0_ScaleCurrent(ADC0_Latest(ADC_SEQ_CURRENT));
 	}
 	else {
-		// Voltage measurement uses a fixed 2.048V reference, independent of VDD.
-		ADC0.CTRLC = (ADC0.CTRLC & ~ADC_REFSEL_gm) | ADC_REFSEL_2048MV_gc;
-		voltageORcurrent->Result = AMC1311_COEF * ADC0_Read(channel);
+		ReadVoltage.Result = ADC0_ScaleVoltage(ADC0_Latest(ADC_SEQ_VOLTAGE));
 	}
 }
+
+/**
+ * @brief ADC0 result ready interrupt (end of a burst).
+ *
+ * Stores the burst mean of the finished step, adapts the profile of voltage and current
+ * steps, updates the VDD tracker after a VDD step and selects input, reference and
+ * profile for the next step, which starts on the next TCA0 overflow event.
+ */
+ISR(ADC0_RESRDY_vect) {
+	uint8_t step = ADCAcquisition.Step;
+	uint16_t sample = ADC0_BurstSample(ADC0_Profile(step)); ///< Mean of the burst, 12-bit scale
+
+	ADC0.INTFLAGS = ADC_RESRDY_bm | ADC_SAMPRDY_bm; ///< Clear flags
+	if (step == ADC_SEQ_VDD) {
+		ADC0_TrackVdd(sample);
+	}
+	else {
+		ADC0_Adapt(step, sample);
+	}
+	ADCAcquisition.Sample[step] = sample;
+	if (step == ADC_SEQ_CURRENT) {
+		ADCAcquisition.Pairs++; // Voltage and current of this round are complete
+		ADCAcquisition.PairTime = SchedulerTicks;
+	}
+
+	step = ADC0_NextStep(step);
+	ADCAcquisition.Step = step;
+	ADC0_SelectStep(step);
+}
@@ -23,13 +23,145 @@
 #define TIMEBASE_VALUE ((uint8_t) ceil(F_CPU * 0.000001))
 
 /**
- * @brief Voltage scaling coefficient for AMC1311 voltage sensor.
+ * @brief Period of the TCA0 event that starts each background ADC conversion, in milliseconds.
+ *
+ * Must be longer than the longest burst of the acquisition profiles (checked below).
+ * Voltage and current alternate, so each is refreshed every 2 periods; VDD is
+ * inserted once every VDD_MEASURE_ROUNDS voltage/current rounds.
+ */
+#define ADC_TRIGGER_PERIOD_MS 10
+
+/**
+ * @brief Acquisition profiles: accumulation, sample duration, prescaler and PGA per burst.
+ *
+ * Voltage and current each switch between a shallow profile while the signal moves and
+ * a deep profile once it is steady; VDD always uses its own profile. The ADC sums
+ * 2^x_SHIFT samples and the interrupt divides the sum back to the 12-bit scale, so the
+ * scaling constants below apply to every profile and only the noise changes.
+ *
+ * - x_SHIFT: log2 of the accumulated samples (ADC_SAMPNUM_ACCn_gc value, 0 to 10).
+ * - x_SAMPDUR: extra sample duration in ADC clock cycles (ADC0.CTRLE).
+ * - x_PRESC / x_PRESC_DIV: ADC clock prescaler (ADC_PRESC_DIVn_gc) and its divisor.
+ * - x_PGA: 0 = PGA bypassed, or ADC_PGAEN_bm | ADC_GAIN_nX_gc | bias for small signals;
+ *   the result is divided by the gain again, so the input must stay below VREF / gain.
+ */
+#define ADC_FAST_SHIFT 4                  ///< 16 samples while a channel is moving
+#define ADC_FAST_SAMPDUR 0
+#define ADC_FAST_PRESC ADC_PRESC_DIV10_gc
+#define ADC_FAST_PRESC_DIV 10
+#define ADC_DEEP_SHIFT 10                 ///< 1024 samples while a channel is steady
+#define ADC_DEEP_SAMPDUR 0
+#define ADC_DEEP_PRESC ADC_PRESC_DIV10_gc
+#define ADC_DEEP_PRESC_DIV 10
+#define ADC_VDD_SHIFT 8                   ///< 256 samples for the VDD/10 input
+#define ADC_VDD_SAMPDUR 0
+#define ADC_VDD_PRESC ADC_PRESC_DIV10_gc
+#define ADC_VDD_PRESC_DIV 10
+#define ADC_CURRENT_PGA 0                 ///< TMCS1100 output is about VDD/2, too large for the PGA gain
+#define ADC_VOLTAGE_PGA 0
+
+/**
+ * @brief Adaptive profile policy.
+ *
+ * A channel whose 12-bit result changes by more than ADC_MOVING_THRESHOLD between two
+ * bursts switches to the fast profile at once; after ADC_STEADY_ROUNDS bursts in a row
+ * below the threshold it returns to the deep profile.
+ */
+#define ADC_MOVING_THRESHOLD 8
+#define ADC_STEADY_ROUNDS 10
+
+/**
+ * @brief Profile figures evaluated at compile time.
+ *
+ * One 12-bit conversion takes about ADC_CONVERSION_CYCLES + SAMPDUR ADC clock cycles.
+ * ADC_BURST_US() is the time from the trigger to the result; ADC_EFFECTIVE_BITS_X2()
+ * is twice the effective resolution gained by oversampling (half a bit per doubling).
+ *
+ * | Profile          | Samples | Burst time | Effective bits |
+ * |------------------|---------|------------|----------------|
+ * | Fast (default)   | 16      | 120 us     | 14             |
+ * | Deep (default)   | 1024    | 7.7 ms     | 17             |
+ * | VDD (default)    | 256     | 1.9 ms     | 16             |
+ */
+#define ADC_CONVERSION_CYCLES 15UL
+#define ADC_BURST_US(shift, sampdur, presc_div) \
+	((1UL << (shift)) * (ADC_CONVERSION_CYCLES + (sampdur)) * (presc_div) * 1000UL / (F_CPU / 1000UL))
+#define ADC_EFFECTIVE_BITS_X2(shift) (24 + (shift))
+#define ADC_FAST_US ADC_BURST_US(ADC_FAST_SHIFT, ADC_FAST_SAMPDUR, ADC_FAST_PRESC_DIV)
+#define ADC_DEEP_US ADC_BURST_US(ADC_DEEP_SHIFT, ADC_DEEP_SAMPDUR, ADC_DEEP_PRESC_DIV)
+#define ADC_VDD_US ADC_BURST_US(ADC_VDD_SHIFT, ADC_VDD_SAMPDUR, ADC_VDD_PRESC_DIV)
+
+#if ADC_FAST_US >= ADC_TRIGGER_PERIOD_MS * 1000UL || ADC_DEEP_US >= ADC_TRIGGER_PERIOD_MS * 1000UL \
+	|| ADC_VDD_US >= ADC_TRIGGER_PERIOD_MS * 1000UL
+#error "An ADC acquisition profile burst is longer than ADC_TRIGGER_PERIOD_MS"
+#endif
+
+/**
+ * @brief Number of voltage/current rounds between two VDD measurements.
+ *
+ * VDD changes slowly, so it is measured on its own low rate (default once per
+ * second) instead of before every current reading.
+ */
+#define VDD_MEASURE_ROUNDS 50
+
+/**
+ * @brief Strength of the VDD low-pass filter: new = old + (sample - old) / 2^VDD_FILTER_SHIFT.
+ */
+#define VDD_FILTER_SHIFT 2
+
+/**
+ * @brief TCA0 period value for ADC_TRIGGER_PERIOD_MS (TCA0 clocked from CLK_PER / 64).
+ */
+#define ADC_TCA_TOP ((uint16_t)(F_CPU / 64 * ADC_TRIGGER_PERIOD_MS / 1000 - 1)) ///< Scaled before dividing, F_CPU / 64 / 1000 is not whole
+
+/**
+ * @brief Full scale of a single 12-bit ADC sample.
+ */
+#define ADC_FULL_SCALE 4096UL
+
+/**
+ * @brief Voltage scaling for the AMC1311 voltage sensor.
  *
  * The AMC1311 has a full input range of 2V which corresponds to 300V (depending on external resistor divider).
  * With the MCU reference voltage at 2.048V, the actual measurable range is 307.2V.
- * This constant converts raw ADC values into a scaled integer voltage representation.
+ * The result is in 0.1V units: Result = (sample  AMC1311_COEF_MUL) >> AMC1311_COEF_SHIFT,
+ * where the multiplier is derived from the constants below (0.75 for the default values).
+ * The shift keeps the rounded multiplier within ADC_COEF_MAX_PPM of the exact ratio,
+ * and 12-bit samples times the multiplier with a calibration gain below 2 fit 32 bits;
+ * both are checked at compile time in ADC.c.
+ */
+#define AMC1311_REF_MV 2048UL         ///< ADC reference used for the voltage channel
+#define AMC1311_INPUT_FS_MV 2000UL    ///< AMC1311 input full scale
+#define AMC1311_INPUT_FS_V 300UL      ///< Solar voltage at AMC1311 full scale
+#define VOLTAGE_UNITS_PER_V 10UL      ///< Result resolution (0.1V)
+#define AMC1311_COEF_SHIFT 19
+#define AMC1311_COEF_MUL ((uint32_t)((((uint64_t)AMC1311_REF_MV * AMC1311_INPUT_FS_V * VOLTAGE_UNITS_PER_V << AMC1311_COEF_SHIFT) \
+	+ ADC_FULL_SCALE * AMC1311_INPUT_FS_MV / 2) / (ADC_FULL_SCALE * AMC1311_INPUT_FS_MV)))
+
+/**
+ * @brief Current scaling for the TMCS1100 current sensor.
+ *
+ * The sensor output is ratiometric to VDD, measured as VDD/10 against the 1.024V reference:
+ * VDD = vdd_sample  10  1.024V / 4096 and I = sample  VDD / 4096 / sensitivity.
+ * The result is in 0.01A units:
+ * I = (sample  ((vdd_sample  TMCS1100_COEF_MUL) >> TMCS1100_VDD_SHIFT)) >> TMCS1100_COEF_SHIFT
+ * (5 / 32768 for the default values). The shifts are split so that both 32-bit products
+ * hold for 12-bit samples and a calibration gain below 2, with the multiplier within
+ * ADC_COEF_MAX_PPM of the exact ratio (checked in ADC.c).
  */
-#define AMC1311_COEF 0.75
+#define VDD_DIVIDER 10UL                  ///< VDD is measured through the internal VDD/10 divider
+#define VDD_REF_MV 1024UL                 ///< ADC reference used for the VDD channel
+#define TMCS1100_SENSITIVITY_MV_A 400UL   ///< TMCS1100A4 sensitivity, mV per A
+#define CURRENT_UNITS_PER_A 100UL         ///< Result resolution (0.01A)
+#define TMCS1100_COEF_SHIFT 19
+#define TMCS1100_VDD_SHIFT 12
+#define TMCS1100_COEF_MUL ((uint32_t)((((uint64_t)VDD_DIVIDER * VDD_REF_MV * CURRENT_UNITS_PER_A << (TMCS1100_COEF_SHIFT + TMCS1100_VDD_SHIFT)) \
+	+ ADC_FULL_SCALE * ADC_FULL_SCALE * TMCS1100_SENSITIVITY_MV_A / 2) / (ADC_FULL_SCALE * ADC_FULL_SCALE * TMCS1100_SENSITIVITY_MV_A)))
+
+/**
+ * @brief Largest error of a rounded scaling multiplier against the exact ratio, in ppm.
+ */
+#define ADC_COEF_MAX_PPM 10
 
 /**
  * @brief Zero-current offset for TMCS1100 current sensor.
@@ -42,11 +174,16 @@
 /**
  * @brief Structure for storing filtered ADC values.
  *
- * Holds the latest result and a buffer of previous ADC readings for filtering (e.g., FIR).
+ * Holds the latest result and the state of the channel's filter pipeline (FIR.h).
+ * Median and boxcar buffers are separate arrays sized per channel; pointers of
+ * disabled stages are NULL.
  */
 typedef struct {
 	uint16_t Result;         ///< Last filtered ADC result
-	uint16_t Filter[FIR_STEPS]; ///< FIR filter buffer
+	uint16_t *Median;        ///< Median window (x_MEDIAN_TAPS entries)
+	uint16_t *Filter;        ///< FIR filter buffer (FIR_STEPS_VOLTAGE or FIR_STEPS_CURRENT entries)
+	uint32_t Sum;            ///< Running sum of the boxcar buffer, or IIR accumulator << IIR_SHIFT
+	uint8_t medianIndex;     ///< Index for the current position in the median window
 	uint8_t index;           ///< Index for the current position in the filter buffer
 } ADC_VALUES;
 
@@ -60,6 +197,80 @@ typedef enum {
 	Current = ADC_MUXPOS_AIN11_gc   ///< ADC channel for current measurement
 } solarrcells_t;
 
+/**
+ * @brief Steps of the background conversion sequence.
+ */
+typedef enum {
+	ADC_SEQ_VOLTAGE = 0, ///< Solar cell voltage (AMC1311)
+	ADC_SEQ_CURRENT,     ///< Solar cell current (TMCS1100)
+	ADC_SEQ_VDD,         ///< MCU supply, VDD/10
+	ADC_SEQ_COUNT        ///< Number of steps
+} adcSequence_t;
+
+/**
+ * @brief Input and reference selection for one sequence step.
+ */
+typedef struct {
+	uint8_t MuxPos; ///< ADC0.MUXPOS value
+	uint8_t RefSel; ///< ADC0.CTRLC reference selection
+} ADC_SEQUENCE_STEP;
+
+/**
+ * @brief Profile selected for a sequence step.
+ */
+typedef enum {
+	ADC_PROFILE_DEEP = 0, ///< Deep oversampling, steady signal
+	ADC_PROFILE_FAST,     ///< Shallow oversampling, moving signal
+	ADC_PROFILES
+} adcProfile_t;
+
+/**
+ * @brief Acquisition settings of one burst (see the x_SHIFT, x_SAMPDUR, x_PRESC, x_PGA macros).
+ */
+typedef struct {
+	uint8_t Shift;   ///< log2 of the accumulated samples, also the ADC0.CTRLF SAMPNUM value
+	uint8_t SampDur; ///< ADC0.CTRLE sample duration
+	uint8_t Presc;   ///< ADC0.CTRLB prescaler
+	uint8_t Pga;     ///< ADC0.PGACTRL value, 0 = PGA bypassed
+} ADC_PROFILE;
+
+/**
+ * @brief Latest raw results of the background acquisition, written by the ADC interrupt.
+ */
+typedef struct {
+	volatile uint16_t Sample[ADC_SEQ_COUNT]; ///< Latest sample per sequence step (12-bit scale)
+	volatile uint8_t Step;                   ///< Step currently being converted
+	uint8_t VddCountdown;                    ///< Voltage/current rounds until the next VDD step
+	volatile uint8_t Profile[ADC_SEQ_COUNT]; ///< Profile per step (adcProfile_t)
+	uint8_t Steady[ADC_SEQ_COUNT];           ///< Bursts in a row below ADC_MOVING_THRESHOLD
+	volatile uint8_t Pairs;                  ///< Completed voltage/current pairs (wraps)
+	volatile uint16_t PairTime;              ///< Scheduler tick of the last completed pair
+} ADC_ACQUISITION;
+
+/**
+ * @brief External background acquisition state.
+ */
+extern ADC_ACQUISITION ADCAcquisition;
+
+/**
+ * @brief Filtered VDD and the current scaling factor derived from it.
+ *
+ * Updated by the ADC interrupt after each VDD measurement, so the current conversion
+ * only needs one multiply with the cached factor.
+ */
+typedef struct {
+	volatile uint16_t Filtered;    ///< Filtered VDD/10 sample << VDD_FILTER_SHIFT
+	volatile uint16_t Sample;      ///< Filtered VDD/10 sample (12-bit)
+	volatile uint32_t CurrentCoef; ///< Sample  calibrated TMCS1100_COEF_MUL >> TMCS1100_VDD_SHIFT, used by the current conversion
+	volatile uint16_t Timestamp;   ///< Scheduler tick of the last VDD measurement
+	volatile uint8_t Valid;        ///< 1 after the first VDD measurement
+} VDD_TRACKER;
+
+/**
+ * @brief External VDD tracker.
+ */
+extern VDD_TRACKER VddTracker;
+
 /**
  * @brief External ADC result holder for current measurements.
  */
@@ -12,6 +12,34 @@
 #ifndef ADCVAR_H_
 #define ADCVAR_H_
 
+/**
+ * @brief Filter pipeline buffers, only allocated for the stages enabled in FIR.h.
+ */
+#if CURRENT_MEDIAN_TAPS
+uint16_t CurrentMedian[CURRENT_MEDIAN_TAPS] = {0};
+#define CURRENT_MEDIAN_BUFFER CurrentMedian
+#else
+#define CURRENT_MEDIAN_BUFFER NULL
+#endif
+#if CURRENT_FILTER == FILTER_BOXCAR
+uint16_t CurrentFilter[FIR_STEPS_CURRENT] = {0};
+#define CURRENT_FILTER_BUFFER CurrentFilter
+#else
+#define CURRENT_FILTER_BUFFER NULL
+#endif
+#if VOLTAGE_MEDIAN_TAPS
+uint16_t VoltageMedian[VOLTAGE_MEDIAN_TAPS] = {0};
+#define VOLTAGE_MEDIAN_BUFFER VoltageMedian
+#else
+#define VOLTAGE_MEDIAN_BUFFER NULL
+#endif
+#if VOLTAGE_FILTER == FILTER_BOXCAR
+uint16_t VoltageFilter[FIR_STEPS_VOLTAGE] = {0};
+#define VOLTAGE_FILTER_BUFFER VoltageFilter
+#else
+#define VOLTAGE_FILTER_BUFFER NULL
+#endif
+
 /**
  * @brief Filtered and raw ADC data for current measurement.
  *
@@ -20,7 +48,10 @@
  */
 ADC_VALUES ReadCurrent = {
 	.Result = 0,    ///< Most recent filtered current measurement result
-	.Filter = {0},  ///< Circular buffer for filtering current readings
+	.Median = CURRENT_MEDIAN_BUFFER, ///< Spike rejection window
+	.Filter = CURRENT_FILTER_BUFFER, ///< Circular buffer for filtering current readings
+	.Sum = 0,       ///< Sum of the buffer
+	.medianIndex = 0, ///< Current index in the median window
 	.index = 0      ///< Current index in the filter buffer
 };
 
@@ -32,8 +63,35 @@ ADC_VALUES ReadCurrent = {
  */
 ADC_VALUES ReadVoltage = {
 	.Result = 0,    ///< Most recent filtered voltage measurement result
-	.Filter = {0},  ///< Circular buffer for filtering voltage readings
+	.Median = VOLTAGE_MEDIAN_BUFFER, ///< Spike rejection window
+	.Filter = VOLTAGE_FILTER_BUFFER, ///< Circular buffer for filtering voltage readings
+	.Sum = 0,       ///< Sum of the buffer
+	.medianIndex = 0, ///< Current index in the median window
 	.index = 0      ///< Current index in the filter buffer
 };
 
+/**
+ * @brief Background acquisition state, starting with the VDD step.
+ */
+ADC_ACQUISITION ADCAcquisition = {
+	.Sample = {0}, ///< No results yet
+	.Step = ADC_SEQ_VDD, ///< VDD is converted first so current scaling is valid early
+	.VddCountdown = VDD_MEASURE_ROUNDS, ///< Rounds until the next VDD measurement
+	.Profile = {ADC_PROFILE_FAST, ADC_PROFILE_FAST, ADC_PROFILE_DEEP}, ///< Fast until the signals settle
+	.Steady = {0},
+	.Pairs = 0,
+	.PairTime = 0
+};
+
+/**
+ * @brief VDD tracker, invalid until the first VDD measurement.
+ */
+VDD_TRACKER VddTracker = {
+	.Filtered = 0,
+	.Sample = 0,
+	.CurrentCoef = 0,
+	.Timestamp = 0,
+	.Valid = 0
+};
+
 #endif /* ADCVAR_H_ */
@@ -1,6 +1,6 @@
 /**
  * @file CRC.c
- * @brief Implementation of CRC-6 (X^6 + X + 1) checksum calculations for MT6701 sensor.
+ * @brief Implementation of CRC-6 (X^6 + X + 1) checksum calculations for MT6701 sensor and the streaming CRC-8/CDMA2000 used by telemetry frames.
  * @author Saulius
  * @date 2024-12-04
  */
@@ -77,29 +77,26 @@ const uint8_t crc8_table[256] = {
 };
 
 /**
- * @brief CRC-8 calculation for CDMA2000 using a precomputed lookup table.
+ * @brief Feeds one byte into a running CRC-8/CDMA2000 calculation.
  * 
- * This function calculates the CRC-8 checksum for the input data using the CDMA2000
- * CRC polynomial. It uses a lookup table to quickly compute the CRC for each byte
- * of the input data. The result is returned as a single byte (CRC value).
+ * Start with CRC8_CDMA2000_INIT, call this for every byte in transmission order and
+ * finish with crc8_cdma2000_final(). Poly 0x9B, init 0xFF, no reflection, no final XOR
+ * (check value for "123456789" is 0xDA).
  * 
- * @param data The input data to calculate the CRC for.
- * @return The CRC-8 checksum value for the data.
+ * @param crc Running CRC value.
+ * @param byte Next data byte.
+ * @return Updated CRC value.
  */
-uint8_t crc8_cdma2000(uint64_t data) {
-    uint8_t crc = 0xFF;    ///< Initial CRC value.
-    size_t length = 0;     ///< Length of the data in bytes.
-    uint64_t temp = data;
-
-    // Calculate the number of bytes in the data.
-    while (temp) {
-        length++;
-        temp >>= 8;
-    }
+uint8_t crc8_cdma2000_update(uint8_t crc, uint8_t byte) {
+    return crc8_table[crc ^ byte];
+}
 
-    // Process each byte in the data.
-    while (length--) {
-        crc = crc8_table[crc ^ ((data >> (length * 8)) & 0xFF)];
-    }
-    return crc;  ///< Return the calculated CRC.
+/**
+ * @brief Finishes a running CRC-8/CDMA2000 calculation.
+ * 
+ * @param crc Running CRC value.
+ * @return The CRC-8 checksum (CDMA2000 has no final XOR, so the value is returned as is).
+ */
+uint8_t crc8_cdma2000_final(uint8_t crc) {
+    return crc;
 }
@@ -0,0 +1,107 @@
+/**
+ * @file Calibration.c
+ * @brief Loading of the per-unit calibration record and current sensor auto-zero.
+ * @author Saulius
+ * @date 2025-06-18
+ */
+
+#include "Settings.h"
+#include "CalibrationVar.h"
+
+_Static_assert(sizeof(CALIBRATION_RECORD) == 15, "Calibration record layout changed: update CALIBRATION_VERSION and test/tools");
+_Static_assert(CALIBRATION_USERROW_OFFSET + sizeof(CALIBRATION_RECORD) <= USER_SIGNATURES_SIZE, "Calibration record does not fit the USERROW");
+
+/**
+ * @brief Checks a calibration record.
+ *
+ * @param record Record read from the USERROW.
+ * @return 1 if version and CRC-8 match, 0 otherwise.
+ */
+static uint8_t Calibration_Valid(const CALIBRATION_RECORD *record) {
+	const uint8_t *data = (const uint8_t *)record;
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	if (record->Version != CALIBRATION_VERSION) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < sizeof(CALIBRATION_RECORD) - 1; i++) {
+		crc = crc8_cdma2000_update(crc, data[i]);
+	}
+	return record->Crc == crc8_cdma2000_final(crc);
+}
+
+/**
+ * @brief Applies a Q1.15 gain to a scaling multiplier without a 64-bit product.
+ *
+ * @param mul Multiplier, below 2^31 (ADC.c checks the 32-bit headroom of twice the multiplier).
+ * @param gain Q1.15 gain.
+ * @return mul × gain rounded down.
+ */
+static uint32_t Calibration_Scale(uint32_t mul, uint16_t gain) {
+	return (mul >> CALIBRATION_GAIN_SHIFT) * gain + (((mul & (CALIBRATION_GAIN_ONE - 1)) * gain) >> CALIBRATION_GAIN_SHIFT);
+}
+
+/**
+ * @brief Precomputes the conversion coefficients from a valid record.
+ *
+ * @param record Checked calibration record.
+ */
+static void Calibration_Apply(const CALIBRATION_RECORD *record) {
+	Calibration.VoltageMul = Calibration_Scale(AMC1311_COEF_MUL, record->VoltageGain);
+	Calibration.VoltageOffset = record->VoltageOffset;
+	Calibration.CurrentMul = Calibration_Scale(TMCS1100_COEF_MUL, record->CurrentGain);
+	Calibration.CurrentZero = record->CurrentZero;
+	Calibration.AngleZero[0] = record->ElevationZero % MT6701_FULL_TURN;
+	Calibration.AngleZero[1] = record->AzimuthZero % MT6701_FULL_TURN;
+	Calibration.Flags = record->Flags;
+	Calibration.Source = CALIBRATION_USERROW;
+}
+
+/**
+ * @brief Loads the calibration record, falling back to the defaults if it is invalid.
+ *
+ * Must run before ADC0_init(), so the first VDD measurement already uses the
+ * calibrated current gain.
+ */
+void Calibration_init() {
+	CALIBRATION_RECORD record;
+	const volatile uint8_t *row = (const volatile uint8_t *)&USERROW + CALIBRATION_USERROW_OFFSET;
+
+	for (uint8_t i = 0; i < sizeof(record); i++) {
+		((uint8_t *)&record)[i] = row[i]; // Memory-mapped, read like RAM
+	}
+	if (Calibration_Valid(&record)) {
+		Calibration_Apply(&record);
+	}
+}
+
+/**
+ * @brief Measures the current sensor zero offset at start-up if CALIBRATION_AUTO_ZERO is set.
+ *
+ * Averages CALIBRATION_AUTO_ZERO_PAIRS current readings taken by the background
+ * acquisition (interrupts must be enabled, runs before the scheduler starts) and uses
+ * the result as the zero offset.
+ * Only valid while no current flows through the string, e.g. with the string
+ * disconnected during start-up.
+ */
+void Calibration_AutoZero() {
+	uint32_t sum = 0;
+	uint8_t pairs;
+
+	if (!(Calibration.Flags & CALIBRATION_AUTO_ZERO)) {
+		return;
+	}
+	pairs = ADCAcquisition.Pairs;
+	for (uint8_t n = 0; n < CALIBRATION_AUTO_ZERO_PAIRS; n++) {
+		while (ADCAcquisition.Pairs == pairs) {
+			sleep_mode(); // Idle sleep, woken by the ADC interrupt
+		}
+		pairs = ADCAcquisition.Pairs;
+		uint32_t coef;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			coef = VddTracker.CurrentCoef;
+		}
+		sum += ((uint32_t)ADC0_Latest(ADC_SEQ_CURRENT) * coef) >> TMCS1100_COEF_SHIFT; // Sensor output without zero offset
+	}
+	Calibration.CurrentZero = (sum + CALIBRATION_AUTO_ZERO_PAIRS / 2) / CALIBRATION_AUTO_ZERO_PAIRS;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file Calibration.h
+ * @brief Per-unit calibration record and the coefficients derived from it.
+ *
+ * The record is stored in the USERROW and written per board over UPDI. At start-up it is
+ * checked (version and CRC) and turned into integer coefficients once; if it is blank
+ * or invalid the compile-time defaults from ADC.h and MT6701.h are used. The
+ * conversions then cost the same as with the fixed macros.
+ *
+ * @author Saulius
+ * @date 2025-06-18
+ */
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+/**
+ * @brief Record layout version, the first byte of the record.
+ */
+#define CALIBRATION_VERSION 1
+
+/**
+ * @brief Offset of the record in the USERROW (mapped at USER_SIGNATURES_START).
+ *
+ * The USERROW is not cleared by a UPDI chip erase, so the calibration survives
+ * reflashing the firmware, and its address does not depend on the link order.
+ */
+#define CALIBRATION_USERROW_OFFSET 0
+
+/**
+ * @brief Gains are unsigned Q1.15 factors: CALIBRATION_GAIN_ONE = 1.0.
+ *
+ * The range is 0 to 0xFFFF / 0x8000 = 1.99997 in steps of 0.00003; a gain of 2.0 or
+ * more cannot be stored. A sensor reading more than 2x too low is a hardware fault,
+ * not a calibration case.
+ */
+#define CALIBRATION_GAIN_SHIFT 15
+#define CALIBRATION_GAIN_ONE (1U << CALIBRATION_GAIN_SHIFT)
+
+/**
+ * @brief Record flags.
+ */
+#define CALIBRATION_ELEVATION_REVERSED 0x01 ///< Elevation reported as MT6701_FULL_TURN - angle
+#define CALIBRATION_AZIMUTH_REVERSED 0x02   ///< Azimuth reported as MT6701_FULL_TURN - angle
+#define CALIBRATION_AUTO_ZERO 0x04          ///< Measure the current sensor zero at start-up
+
+/**
+ * @brief Current readings averaged by the start-up auto-zero (no current may flow).
+ */
+#define CALIBRATION_AUTO_ZERO_PAIRS 16
+
+/**
+ * @brief Calibration record as stored in the USERROW (little-endian, packed, 15 bytes).
+ *
+ * test/tools/MakeCalibration writes a record as Intel HEX for programming over UPDI.
+ */
+typedef struct __attribute__((packed)) {
+	uint8_t Version;        ///< CALIBRATION_VERSION
+	uint16_t VoltageGain;   ///< Voltage gain correction, Q1.15
+	int16_t VoltageOffset;  ///< Added to the voltage, 0.1V
+	uint16_t CurrentGain;   ///< Current gain correction, Q1.15
+	uint16_t CurrentZero;   ///< Current sensor zero offset, 0.01A (default TMCS1100_ZERO_I)
+	uint16_t ElevationZero; ///< Subtracted from the elevation angle, 0.01 degree
+	uint16_t AzimuthZero;   ///< Subtracted from the azimuth angle, 0.01 degree
+	uint8_t Flags;          ///< CALIBRATION_x flags
+	uint8_t Crc;            ///< CRC-8/CDMA2000 of the preceding bytes
+} CALIBRATION_RECORD;
+
+/**
+ * @brief Where the coefficients in use came from.
+ */
+typedef enum {
+	CALIBRATION_DEFAULTS = 0, ///< No valid record, compile-time defaults
+	CALIBRATION_USERROW       ///< Valid USERROW record
+} calibrationSource_t;
+
+/**
+ * @brief Coefficients used by the conversions, precomputed from the record.
+ */
+typedef struct {
+	uint32_t VoltageMul;   ///< Voltage = sample × VoltageMul >> AMC1311_COEF_SHIFT (gain applied)
+	int16_t VoltageOffset; ///< 0.1V
+	uint32_t CurrentMul;   ///< VddTracker.CurrentCoef = vdd_sample × CurrentMul >> TMCS1100_VDD_SHIFT (gain applied)
+	uint16_t CurrentZero;  ///< 0.01A
+	uint16_t AngleZero[2]; ///< Elevation, azimuth zero offsets, 0.01 degree
+	uint8_t Flags;         ///< CALIBRATION_x flags
+	uint8_t Source;        ///< calibrationSource_t
+} CALIBRATION;
+
+/**
+ * @brief Coefficients in use, defined in CalibrationVar.h.
+ */
+extern CALIBRATION Calibration;
+
+#endif /* CALIBRATION_H_ */
@@ -0,0 +1,26 @@
+/**
+ * @file CalibrationVar.h
+ * @brief Calibration coefficients.
+ *
+ * The coefficients start with the compile-time defaults, so conversions are valid even
+ * before Calibration_init() has run.
+ *
+ * @author Saulius
+ * @date 2025-06-18
+ */
+
+#ifndef CALIBRATIONVAR_H_
+#define CALIBRATIONVAR_H_
+
+CALIBRATION Calibration = {
+	.VoltageMul = AMC1311_COEF_MUL,
+	.VoltageOffset = 0,
+	.CurrentMul = TMCS1100_COEF_MUL,
+	.CurrentZero = TMCS1100_ZERO_I,
+	.AngleZero = {0, 0},
+	.Flags = (MT6701_ELEVATION_REVERSED ? CALIBRATION_ELEVATION_REVERSED : 0)
+		| (MT6701_AZIMUTH_REVERSED ? CALIBRATION_AZIMUTH_REVERSED : 0),
+	.Source = CALIBRATION_DEFAULTS
+};
+
+#endif /* CALIBRATIONVAR_H_ */
@@ -0,0 +1,117 @@
+/**
+ * @file Diagnostics.c
+ * @brief Stage timing statistics and the periodic diagnostic frame.
+ *
+ * Decoded diagnostic frame (all values big-endian):
+ *
+ * | Byte     | Content                                        |
+ * |----------|------------------------------------------------|
+ * | 0        | DIAG_FRAME_ID                                  |
+ * | 1..36    | Last, min, max time in us for each diagStage_t |
+ * | 37..38   | USART1 transmit overflow count                 |
+ * | 39..40   | CPU awake time since the last frame, per mille |
+ * | 41..42   | Age of the last VDD measurement, ms            |
+ * | 43, 44   | Elevation, azimuth Age (reads since last good) |
+ * | 45..48   | Elevation CommErrors, FieldErrors              |
+ * | 49..52   | Azimuth CommErrors, FieldErrors                |
+ * | 53..54   | End switch events since start-up               |
+ * | 55       | CRC-8/CDMA2000 of bytes 0..54                  |
+ *
+ * In binary mode the frame is COBS encoded like a telemetry frame. In ASCII mode it is
+ * sent as DIAG_ASCII_START, the bytes in hex and "\r\n", which legacy receivers skip
+ * because it does not start with '<'.
+ *
+ * @author Saulius
+ * @date 2025-06-10
+ */
+
+#include "Settings.h"
+
+#if DIAG_ENABLE
+#include "DiagnosticsVar.h"
+
+#if TELEMETRY_RAW_FRAME(DIAG_PAYLOAD) >= USART1_TX_BUFFER_SIZE
+#error "The diagnostic frame does not fit in USART1_TX_BUFFER_SIZE"
+#endif
+
+/**
+ * @brief Adds one measurement to the statistics of a stage.
+ *
+ * @param stage Timed stage.
+ * @param time Run time in microseconds.
+ */
+void Diag_Record(diagStage_t stage, uint16_t time) {
+	DIAG_STAGE_TIME *entry = &DiagStages[stage];
+
+	entry->Last = time;
+	if (time < entry->Min) entry->Min = time;
+	if (time > entry->Max) entry->Max = time;
+}
+
+/**
+ * @brief Stores a 16-bit value big-endian.
+ *
+ * @param out Output position.
+ * @param value Value to store.
+ * @return Output position after the value.
+ */
+static uint8_t *Diag_PutWord(uint8_t *out, uint16_t value) {
+	*out++ = value >> 8;
+	*out++ = value;
+	return out;
+}
+
+/**
+ * @brief Awake share of the CPU since the previous call, from the scheduler sleep time.
+ *
+ * @return Awake time in per mille (0 to 1000).
+ */
+static uint16_t Diag_AwakePermille() {
+	static uint16_t window_start = 0; ///< Tick of the previous report
+	uint16_t now = Scheduler_Millis();
+	uint16_t window = now - window_start;
+	uint32_t asleep = SchedulerSleepUs / (window ? window : 1); // us per ms = asleep per mille
+
+	window_start = now;
+	SchedulerSleepUs = 0;
+	return asleep >= 1000 ? 0 : 1000 - asleep;
+}
+
+/**
+ * @brief Sends the diagnostic frame and starts a new min/max window.
+ */
+void Task_Diagnostics() {
+	uint8_t payload[DIAG_PAYLOAD];
+	uint8_t *out = payload;
+	uint8_t crc = CRC8_CDMA2000_INIT;
+	uint16_t events;
+
+	*out++ = DIAG_FRAME_ID;
+	for (uint8_t i = 0; i < DIAG_STAGES; i++) {
+		DIAG_STAGE_TIME *entry = &DiagStages[i];
+		out = Diag_PutWord(out, entry->Last);
+		out = Diag_PutWord(out, entry->Min);
+		out = Diag_PutWord(out, entry->Max);
+		entry->Min = UINT16_MAX; // New window
+		entry->Max = 0;
+	}
+	out = Diag_PutWord(out, USART1TX.overflowCount);
+	out = Diag_PutWord(out, Diag_AwakePermille());
+	out = Diag_PutWord(out, ADC0_VddAge()); // About 1 s at most while the background sequence runs
+	*out++ = MT6701ELEVATION.Age;
+	*out++ = MT6701AZIMUTH.Age;
+	out = Diag_PutWord(out, MT6701ELEVATION.CommErrors);
+	out = Diag_PutWord(out, MT6701ELEVATION.FieldErrors);
+	out = Diag_PutWord(out, MT6701AZIMUTH.CommErrors);
+	out = Diag_PutWord(out, MT6701AZIMUTH.FieldErrors);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		events = YSwitch.Events; // Also counted in the pin change interrupt
+	}
+	out = Diag_PutWord(out, events);
+	for (uint8_t *p = payload; p < out; p++) {
+		crc = crc8_cdma2000_update(crc, *p);
+	}
+	*out = crc8_cdma2000_final(crc);
+	Telemetry_SendRaw(payload, DIAG_PAYLOAD, DIAG_ASCII_START);
+}
+#endif
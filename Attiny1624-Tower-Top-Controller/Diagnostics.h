@@ -0,0 +1,83 @@
+/**
+ * @file Diagnostics.h
+ * @brief On-target stage timing instrumentation and the diagnostic frame.
+ *
+ * DIAG_BEGIN()/DIAG_END() pairs around a stage measure its run time with
+ * Scheduler_Micros(). The last, minimum and maximum time of every stage is kept and
+ * sent periodically in a diagnostic frame. With DIAG_ENABLE set to 0 the macros,
+ * the statistics and the diagnostic task compile out completely.
+ *
+ * @author Saulius
+ * @date 2025-06-10
+ */
+
+#ifndef DIAGNOSTICS_H_
+#define DIAGNOSTICS_H_
+
+/**
+ * @brief Enables stage timing and the diagnostic frame (1) or removes them (0).
+ */
+#ifndef DIAG_ENABLE
+#define DIAG_ENABLE 0 ///< May be overridden from the compiler command line
+#endif
+
+/**
+ * @brief Diagnostic frame period and phase offset in milliseconds (ticks).
+ *
+ * The offset keeps the frame away from the telemetry frame of the same period.
+ */
+#define TASK_DIAGNOSTICS_PERIOD_MS 1000
+#define TASK_DIAGNOSTICS_OFFSET_MS 75
+
+/**
+ * @brief First byte of the decoded diagnostic frame.
+ *
+ * Never used as a telemetry version, so a binary receiver can tell the frames apart.
+ * In ASCII mode the frame starts with DIAG_ASCII_START instead of '<'.
+ */
+#define DIAG_FRAME_ID 0xD1
+#define DIAG_ASCII_START '#'
+
+/**
+ * @brief Timed stages.
+ */
+typedef enum {
+	DIAG_SSI_ELEVATION, ///< MT6701 elevation read (retries included)
+	DIAG_SSI_AZIMUTH,   ///< MT6701 azimuth read (retries included)
+	DIAG_VOLTAGE,       ///< Voltage sample, scaling and filter
+	DIAG_CURRENT,       ///< Current sample, scaling and filter
+	DIAG_SERIALIZE,     ///< Telemetry frame packing, CRC and encoding
+	DIAG_TX,            ///< Telemetry frame queueing on USART1
+	DIAG_STAGES
+} diagStage_t;
+
+/**
+ * @brief Decoded diagnostic frame length: ID, last/min/max per stage, USART1 overflow count,
+ * awake time in per mille, VDD measurement age, MT6701 ages and error counters, end switch
+ * events and CRC-8.
+ */
+#define DIAG_PAYLOAD (1 + DIAG_STAGES * 6 + 2 + 2 + 2 + 2 + 2 * 4 + 2 + 1)
+
+/**
+ * @brief Run time statistics of one stage in microseconds.
+ */
+typedef struct {
+	uint16_t Last; ///< Last measured time
+	uint16_t Min;  ///< Shortest time since the last diagnostic frame
+	uint16_t Max;  ///< Longest time since the last diagnostic frame
+} DIAG_STAGE_TIME;
+
+#if DIAG_ENABLE
+/**
+ * @brief Stage statistics, defined in Diagnostics.c.
+ */
+extern DIAG_STAGE_TIME DiagStages[DIAG_STAGES];
+
+#define DIAG_BEGIN(stage) uint16_t diag_start_##stage = Scheduler_Micros() ///< Starts timing a stage
+#define DIAG_END(stage) Diag_Record(stage, Scheduler_Micros() - diag_start_##stage) ///< Stops timing a stage
+#else
+#define DIAG_BEGIN(stage)
+#define DIAG_END(stage)
+#endif
+
+#endif /* DIAGNOSTICS_H_ */
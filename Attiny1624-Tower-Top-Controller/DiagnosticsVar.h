@@ -0,0 +1,25 @@
+/**
+ * @file DiagnosticsVar.h
+ * @brief Stage timing statistics.
+ *
+ * Min starts at UINT16_MAX so the first measurement of a window sets it.
+ *
+ * @author Saulius
+ * @date 2025-06-10
+ */
+
+#ifndef DIAGNOSTICSVAR_H_
+#define DIAGNOSTICSVAR_H_
+
+#define DIAG_STAGE_INIT { .Last = 0, .Min = UINT16_MAX, .Max = 0 }
+
+DIAG_STAGE_TIME DiagStages[DIAG_STAGES] = {
+	[DIAG_SSI_ELEVATION] = DIAG_STAGE_INIT,
+	[DIAG_SSI_AZIMUTH] = DIAG_STAGE_INIT,
+	[DIAG_VOLTAGE] = DIAG_STAGE_INIT,
+	[DIAG_CURRENT] = DIAG_STAGE_INIT,
+	[DIAG_SERIALIZE] = DIAG_STAGE_INIT,
+	[DIAG_TX] = DIAG_STAGE_INIT
+};
+
+#endif /* DIAGNOSTICSVAR_H_ */
@@ -0,0 +1,127 @@
+/**
+ * @file Energy.c
+ * @brief Power and energy integration with wear-levelled EEPROM persistence.
+ * @author Saulius
+ * @date 2025-06-16
+ */
+
+#include "Settings.h"
+#include "EnergyVar.h"
+
+_Static_assert((uint64_t)(ENERGY_MW_MS_PER_UNIT - 1) * (ENERGY_MAX_DT_MS + 1) <= UINT32_MAX, "Energy remainder can overflow: shorten ENERGY_MAX_DT_MS");
+
+/**
+ * @brief CRC-8/CDMA2000 of an EEPROM record without its CRC byte.
+ */
+static uint8_t Energy_SlotCrc(const ENERGY_SLOT *slot) {
+	const uint8_t *data = (const uint8_t *)slot;
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	for (uint8_t i = 0; i < sizeof(ENERGY_SLOT) - 1; i++) {
+		crc = crc8_cdma2000_update(crc, data[i]);
+	}
+	return crc8_cdma2000_final(crc);
+}
+
+/**
+ * @brief Restores the energy counter from the newest valid EEPROM slot.
+ */
+void Energy_init() {
+	uint8_t found = 0;
+
+	for (uint8_t i = 0; i < ENERGY_SLOTS; i++) {
+		ENERGY_SLOT slot;
+		eeprom_read_block(&slot, &EnergySlots[i], sizeof(slot));
+		if (slot.Crc != Energy_SlotCrc(&slot)) {
+			continue; // Blank or torn write
+		}
+		if (!found || (int16_t)(slot.Sequence - EnergyMeter.Sequence) > 0) {
+			EnergyMeter.Energy = slot.Energy;
+			EnergyMeter.Sequence = slot.Sequence;
+			EnergyMeter.Slot = i;
+			found = 1;
+		}
+	}
+	EnergyMeter.Saved = EnergyMeter.Energy;
+}
+
+/**
+ * @brief Starts saving the counter to the next slot of the EEPROM ring if it has changed.
+ *
+ * Only prepares the record; Energy_WriteStep() writes it byte by byte. The older slots
+ * stay intact, so a reset during the write falls back to the previous record.
+ */
+static void Energy_Save() {
+	ENERGY_SLOT *slot = &EnergyMeter.Record;
+
+	if (EnergyMeter.Energy == EnergyMeter.Saved || EnergyMeter.Writing) {
+		return; // Nothing new (save an EEPROM write) or the previous record is still being written
+	}
+	EnergyMeter.Slot = (EnergyMeter.Slot + 1) % ENERGY_SLOTS;
+	EnergyMeter.Sequence++;
+	slot->Energy = EnergyMeter.Energy;
+	slot->Sequence = EnergyMeter.Sequence;
+	slot->Reserved = 0xFF;
+	slot->Crc = Energy_SlotCrc(slot);
+	EnergyMeter.Writing = sizeof(ENERGY_SLOT);
+	EnergyMeter.Saved = EnergyMeter.Energy;
+}
+
+/**
+ * @brief Writes the next byte of a record being saved once the EEPROM is ready.
+ *
+ * One byte per task run, so the CPU never waits for the EEPROM: a byte write keeps it
+ * busy for several milliseconds, and a whole record written at once would stall the
+ * scheduler for tens of them. The CRC is the last byte of the record and is written
+ * last, so a record torn by a reset fails its CRC check.
+ */
+static void Energy_WriteStep() {
+	if (EnergyMeter.Writing && eeprom_is_ready()) {
+		uint8_t index = sizeof(ENERGY_SLOT) - EnergyMeter.Writing--;
+		eeprom_update_byte((uint8_t *)&EnergySlots[EnergyMeter.Slot] + index, ((const uint8_t *)&EnergyMeter.Record)[index]);
+	}
+}
+
+/**
+ * @brief Integrates the newest voltage/current pair and saves the counter periodically.
+ */
+void Task_Energy() {
+	uint8_t pairs;
+	uint16_t pairTime;
+	uint16_t voltage;
+	uint16_t current;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { // Samples and their pair count from the same moment
+		pairs = ADCAcquisition.Pairs;
+		pairTime = ADCAcquisition.PairTime;
+		voltage = ADCAcquisition.Sample[ADC_SEQ_VOLTAGE];
+		current = ADCAcquisition.Sample[ADC_SEQ_CURRENT];
+	}
+	if (pairs != EnergyMeter.Pairs) {
+		uint32_t power = (uint32_t)ADC0_ScaleVoltage(voltage) * ADC0_ScaleCurrent(current); ///< mW
+
+		if (EnergyMeter.Valid) {
+			uint16_t dt = pairTime - EnergyMeter.PairTime;
+			if (dt > ENERGY_MAX_DT_MS) dt = ENERGY_MAX_DT_MS;
+			uint32_t mean = (EnergyMeter.Power >> 1) + (power >> 1) + (EnergyMeter.Power & power & 1); // Trapezoidal rule, mW
+			uint16_t units = mean / ENERGY_MW_MS_PER_UNIT;
+
+			EnergyMeter.Energy += (uint32_t)units * dt; // Whole units first, mean * dt may exceed 32 bits
+			EnergyMeter.Remainder += (mean - units * ENERGY_MW_MS_PER_UNIT) * dt;
+			if (EnergyMeter.Remainder >= ENERGY_MW_MS_PER_UNIT) {
+				EnergyMeter.Energy += EnergyMeter.Remainder / ENERGY_MW_MS_PER_UNIT;
+				EnergyMeter.Remainder %= ENERGY_MW_MS_PER_UNIT;
+			}
+		}
+		EnergyMeter.Power = power;
+		EnergyMeter.PairTime = pairTime;
+		EnergyMeter.Pairs = pairs;
+		EnergyMeter.Valid = 1;
+	}
+
+	if (!--EnergyMeter.SaveCountdown) {
+		EnergyMeter.SaveCountdown = ENERGY_SAVE_INTERVAL_S * 1000UL / TASK_ENERGY_PERIOD_MS;
+		Energy_Save();
+	}
+	Energy_WriteStep();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file Energy.h
+ * @brief Solar string power and energy integration.
+ *
+ * Power is computed from every voltage/current pair of the background acquisition
+ * (0.1V × 0.01A = 1 mW) and integrated with the trapezoidal rule over the actual time
+ * between pairs. Whole mWh are added to a 32-bit counter, the rest is kept in mW·ms.
+ * The counter is saved to EEPROM every ENERGY_SAVE_INTERVAL_S in a ring of
+ * ENERGY_SLOTS records, so each EEPROM cell is written once per
+ * ENERGY_SLOTS × ENERGY_SAVE_INTERVAL_S; at most one save interval is lost on reset.
+ * A record is written one byte per energy task run while the EEPROM is ready, so a
+ * save takes sizeof(ENERGY_SLOT) runs (80 ms) and never blocks the CPU.
+ * A UPDI chip erase clears the EEPROM unless the EESAVE fuse (FUSE.SYSCFG0) is set, so
+ * program it once per board to keep the counter across firmware updates.
+ *
+ * @author Saulius
+ * @date 2025-06-16
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+/**
+ * @brief Energy task period in milliseconds, one voltage/current pair at most every
+ * two ADC trigger periods.
+ */
+#define TASK_ENERGY_PERIOD_MS ADC_TRIGGER_PERIOD_MS
+#define TASK_ENERGY_OFFSET_MS 5
+
+/**
+ * @brief One energy counter unit (1 mWh) in mW·ms.
+ */
+#define ENERGY_MW_MS_PER_UNIT 3600000UL
+
+/**
+ * @brief Longest interval integrated between two pairs in milliseconds.
+ *
+ * A longer gap, e.g. after the acquisition stalled, is counted as this long. Whole
+ * counter units of the mean power are carried before the multiplication, so only the
+ * part below ENERGY_MW_MS_PER_UNIT is multiplied by the interval: the 32-bit mW·ms
+ * remainder cannot overflow for any power the 16-bit scaled voltage and current can
+ * give (up to 6553.5 V × 655.35 A with the largest calibration gains).
+ */
+#define ENERGY_MAX_DT_MS 1000
+
+/**
+ * @brief EEPROM persistence: save interval in seconds and number of ring slots.
+ */
+#define ENERGY_SAVE_INTERVAL_S 3600UL
+#define ENERGY_SLOTS 8
+
+/**
+ * @brief Energy counter record in EEPROM.
+ */
+typedef struct {
+	uint32_t Energy;   ///< Energy counter in mWh
+	uint16_t Sequence; ///< Save counter, the newest valid slot wins (wrap-aware)
+	uint8_t Reserved;  ///< 0xFF
+	uint8_t Crc;       ///< CRC-8/CDMA2000 of the preceding bytes
+} ENERGY_SLOT;
+
+/**
+ * @brief Integration state.
+ */
+typedef struct {
+	uint32_t Energy;       ///< Energy counter in mWh (wraps)
+	uint32_t Remainder;    ///< Energy below one counter unit, mW·ms
+	uint32_t Power;        ///< Power of the last pair in mW
+	uint16_t PairTime;     ///< Tick of the last integrated pair
+	uint8_t Pairs;         ///< ADCAcquisition.Pairs at the last integration
+	uint8_t Valid;         ///< 1 once a first pair has been taken
+	uint32_t SaveCountdown;///< Task runs until the next EEPROM save
+	uint16_t Sequence;     ///< Sequence of the last saved slot
+	uint8_t Slot;          ///< Index of the last saved slot
+	uint32_t Saved;        ///< Energy value of the last save
+	ENERGY_SLOT Record;    ///< Record being written to EnergySlots[Slot]
+	uint8_t Writing;       ///< Bytes of Record left to write (0 = idle)
+} ENERGY_METER;
+
+/**
+ * @brief Energy meter, defined in EnergyVar.h.
+ */
+extern ENERGY_METER EnergyMeter;
+
+#endif /* ENERGY_H_ */
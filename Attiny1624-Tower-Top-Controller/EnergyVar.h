@@ -0,0 +1,35 @@
+/**
+ * @file EnergyVar.h
+ * @brief Energy meter state and its EEPROM ring.
+ *
+ * The counter starts at 0 and is replaced by the newest valid EEPROM slot in
+ * Energy_init().
+ *
+ * @author Saulius
+ * @date 2025-06-16
+ */
+
+#ifndef ENERGYVAR_H_
+#define ENERGYVAR_H_
+
+ENERGY_METER EnergyMeter = {
+	.Energy = 0,
+	.Remainder = 0,
+	.Power = 0,
+	.PairTime = 0,
+	.Pairs = 0,
+	.Valid = 0,
+	.SaveCountdown = ENERGY_SAVE_INTERVAL_S * 1000UL / TASK_ENERGY_PERIOD_MS,
+	.Sequence = 0,
+	.Slot = ENERGY_SLOTS - 1, ///< First save goes to slot 0 when EEPROM is blank
+	.Saved = 0,
+	.Record = { 0 },
+	.Writing = 0
+};
+
+/**
+ * @brief EEPROM ring of energy counter records (erased EEPROM reads 0xFF, CRC invalid).
+ */
+ENERGY_SLOT EEMEM EnergySlots[ENERGY_SLOTS];
+
+#endif /* ENERGYVAR_H_ */
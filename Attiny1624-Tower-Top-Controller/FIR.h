@@ -11,5 +11,69 @@
 
 #define FIR_STEPS 20 //More steps meaning better filtration but slower signal response
 
+/**
+ * @brief Smoothing stage options.
+ */
+#define FILTER_NONE 0   ///< No smoothing, output of the median stage is used as is
+#define FILTER_BOXCAR 1 ///< Moving average over FIR_STEPS_x samples (RAM: 2 bytes per step)
+#define FILTER_IIR 2    ///< First-order low-pass, y += (x - y) / 2^IIR_SHIFT (no buffer)
 
-#endif /* FIR_H_ */
\ No newline at end of file
+/**
+ * @brief Filter pipeline configuration per channel.
+ *
+ * Each measurement first passes an optional median-of-N spike rejector
+ * (x_MEDIAN_TAPS = 0 disables it, otherwise 3 or 5; RAM: 2 bytes per tap) and then
+ * the selected smoothing stage. Buffers are only allocated for the enabled stages.
+ */
+#define VOLTAGE_MEDIAN_TAPS 0
+#define VOLTAGE_FILTER FILTER_BOXCAR
+#define VOLTAGE_IIR_SHIFT 3
+
+#define CURRENT_MEDIAN_TAPS 3 ///< Rejects single inverter switching spikes
+#define CURRENT_FILTER FILTER_BOXCAR
+#define CURRENT_IIR_SHIFT 3
+
+/**
+ * @brief Largest supported median window.
+ */
+#define FILTER_MEDIAN_MAX_TAPS 5
+
+/**
+ * @brief Moving average length per channel (1 to 255), used with FILTER_BOXCAR.
+ *
+ * Lengths that are a power of two, or a power of two times an odd factor up to 16
+ * (e.g. 20 = 4 x 5), avoid the 32-bit division on every call.
+ */
+#define FIR_STEPS_VOLTAGE FIR_STEPS
+#define FIR_STEPS_CURRENT FIR_STEPS
+
+/**
+ * @brief Largest value fed into the filter (12-bit ADC based results).
+ */
+#define FIR_SAMPLE_MAX 4095UL
+
+#define FIR_POW2_PART(n) ((n) & -(n))          ///< Largest power of two dividing n
+#define FIR_ODD_PART(n) ((n) / FIR_POW2_PART(n)) ///< Remaining odd factor of n
+
+/**
+ * @brief floor(sum / n) for a compile-time constant n.
+ *
+ * Divides by the power of two part with a shift, then by the odd part in 16-bit
+ * arithmetic (which the compiler turns into a multiply) when the shifted sum fits
+ * 16 bits; otherwise falls back to the plain 32-bit division. floor(floor(s / a) / b)
+ * equals floor(s / (a * b)), so the result is identical to sum / n.
+ */
+#define FIR_DIVIDE(sum, n) \
+	((FIR_ODD_PART(n) * FIR_SAMPLE_MAX <= 0xFFFF) \
+	? (uint16_t)((uint16_t)((sum) / FIR_POW2_PART(n)) / FIR_ODD_PART(n)) \
+	: (uint16_t)((sum) / (n)))
+
+#if (FIR_STEPS_VOLTAGE < 1) || (FIR_STEPS_VOLTAGE > 255) || (FIR_STEPS_CURRENT < 1) || (FIR_STEPS_CURRENT > 255)
+#error "FIR_STEPS_VOLTAGE and FIR_STEPS_CURRENT must be between 1 and 255"
+#endif
+
+#if (VOLTAGE_MEDIAN_TAPS != 0 && VOLTAGE_MEDIAN_TAPS != 3 && VOLTAGE_MEDIAN_TAPS != 5) || (CURRENT_MEDIAN_TAPS != 0 && CURRENT_MEDIAN_TAPS != 3 && CURRENT_MEDIAN_TAPS != 5)
+#error "VOLTAGE_MEDIAN_TAPS and CURRENT_MEDIAN_TAPS must be 0, 3 or 5"
+#endif
+
+#endif /* FIR_H_ */
@@ -1,9 +1,10 @@
 /**
  * @file Filter.c
- * @brief Implementation of a simple FIR filter for solar cell voltage and current measurements.
+ * @brief Filter pipeline for solar cell voltage and current measurements.
  *
- * Applies a fixed-length moving average (FIR) filter to smooth out readings from solar sensors.
- * This is used to reduce noise in both voltage and current measurements.
+ * Each channel passes an optional median-of-N spike rejector followed by a moving
+ * average (boxcar, FIR) or a first-order fixed-point IIR low-pass, as configured per
+ * channel in FIR.h. This is used to reduce noise in both voltage and current measurements.
  *
  * @author Saulius
  * @date 2025-03-06
@@ -12,34 +13,112 @@
 #include "Settings.h"
 
 /**
- * @brief Applies FIR (Finite Impulse Response) filtering to the selected ADC channel.
+ * @brief Median-of-N spike rejection stage.
  *
- * Reads a new ADC value (voltage or current), stores it in the filter buffer, and calculates the average.
+ * @param values Channel state (median window).
+ * @param taps Window length (3 or 5).
+ * @param sample New measurement.
+ * @return Median of the last taps measurements.
+ */
+static inline __attribute__((always_inline)) uint16_t Filter_Median(ADC_VALUES *values, uint8_t taps, uint16_t sample) {
+	uint16_t sorted[FILTER_MEDIAN_MAX_TAPS];
+
+	values->Median[values->medianIndex] = sample;
+	if (++values->medianIndex >= taps) {
+		values->medianIndex = 0;
+	}
+
+	// Insertion sort of the small window
+	for (uint8_t i = 0; i < taps; i++) {
+		uint16_t v = values->Median[i];
+		uint8_t j = i;
+		while (j && sorted[j - 1] > v) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = v;
+	}
+	return sorted[taps / 2];
+}
+
+/**
+ * @brief Moving average (boxcar) stage with a running sum.
  *
- * - Voltage or current value is selected based on the channel input.
- * - The new measurement is added to a circular buffer.
- * - The filtered result is calculated as the average of all samples in the buffer.
+ * The new measurement replaces the oldest one in the circular buffer and in the sum;
+ * the sum is divided by the compile-time buffer length (FIR_DIVIDE), identical to
+ * averaging the whole buffer.
  *
- * @param channel Specifies whether to process voltage or current (Voltage or Current).
+ * @param values Channel state (filter buffer and sum).
+ * @param steps Buffer length.
+ * @param sample New measurement.
+ * @return Average of the last steps measurements.
  */
-void FIR(solarrcells_t channel) {
-	ReadSolarCells(channel); ///< Read raw measurement from the selected ADC channel
-
-	// Select target ADC_VALUES structure based on the channel (voltage or current)
-	ADC_VALUES *voltageORcurrent = (channel == Voltage) ? &ReadVoltage : &ReadCurrent;
+static inline __attribute__((always_inline)) uint16_t Filter_Boxcar(ADC_VALUES *values, uint8_t steps, uint16_t sample) {
+	uint16_t *slot = &values->Filter[values->index];
 
-	// Store the latest measurement into the filter buffer at the current index
-	voltageORcurrent->Filter[voltageORcurrent->index] = voltageORcurrent->Result;
+	values->Sum += sample;
+	values->Sum -= *slot;
+	*slot = sample;
 
 	// Update the index (circular buffer behavior)
-	voltageORcurrent->index = (voltageORcurrent->index + 1) % FIR_STEPS;
+	if (++values->index >= steps) {
+		values->index = 0;
+	}
+	return FIR_DIVIDE(values->Sum, steps);
+}
 
-	// Calculate the sum of all values in the buffer
-	uint32_t sum = 0; ///< uint32_t is sufficient to store sum of up to 65535 uint16_t values
-	for (uint8_t i = 0; i < FIR_STEPS; i++) {
-		sum += voltageORcurrent->Filter[i];
+/**
+ * @brief First-order IIR low-pass stage: y += (x - y) / 2^shift in fixed point.
+ *
+ * Sum holds y scaled by 2^shift, so a constant input settles at exactly Sum >> shift == x
+ * (unity DC gain). The difference may be negative; the unsigned addition wraps back.
+ *
+ * @param values Channel state (accumulator in Sum, scaled by 2^shift).
+ * @param shift Filter strength; time constant is about 2^shift samples.
+ * @param sample New measurement.
+ * @return Filtered value.
+ */
+static inline __attribute__((always_inline)) uint16_t Filter_Iir(ADC_VALUES *values, uint8_t shift, uint16_t sample) {
+	values->Sum += sample - (values->Sum >> shift);
+	return values->Sum >> shift;
+}
+
+/**
+ * @brief Runs one measurement through a channel's pipeline.
+ *
+ * All parameters are compile-time constants at the call sites, so disabled stages are
+ * removed and divisions are specialized per channel.
+ */
+static inline __attribute__((always_inline)) uint16_t Filter_Pipeline(ADC_VALUES *values, uint8_t medianTaps, uint8_t filter, uint8_t steps, uint8_t shift) {
+	uint16_t sample = values->Result;
+
+	if (medianTaps) {
+		sample = Filter_Median(values, medianTaps, sample);
 	}
+	if (filter == FILTER_BOXCAR) {
+		sample = Filter_Boxcar(values, steps, sample);
+	}
+	else if (filter == FILTER_IIR) {
+		sample = Filter_Iir(values, shift, sample);
+	}
+	return sample;
+}
+
+/**
+ * @brief Applies the filter pipeline to the selected ADC channel.
+ *
+ * Reads a new ADC value (voltage or current) and passes it through the channel's
+ * median and smoothing stages configured in FIR.h.
+ *
+ * @param channel Specifies whether to process voltage or current (Voltage or Current).
+ */
+void FIR(solarrcells_t channel) {
+	ReadSolarCells(channel); ///< Read raw measurement from the selected ADC channel
 
-	// Store the filtered result as the average of the buffer
-	voltageORcurrent->Result = sum / FIR_STEPS;
+	if (channel == Voltage) {
+		ReadVoltage.Result = Filter_Pipeline(&ReadVoltage, VOLTAGE_MEDIAN_TAPS, VOLTAGE_FILTER, FIR_STEPS_VOLTAGE, VOLTAGE_IIR_SHIFT);
+	}
+	else {
+		ReadCurrent.Result = Filter_Pipeline(&ReadCurrent, CURRENT_MEDIAN_TAPS, CURRENT_FILTER, FIR_STEPS_CURRENT, CURRENT_IIR_SHIFT);
+	}
 }
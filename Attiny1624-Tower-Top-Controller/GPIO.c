@@ -24,4 +24,5 @@ void GPIO_init(){
 
 	PORTB.PIN0CTRL = PORT_ISC_INPUT_DISABLE_gc; ///< Turn off digital buffer for PB0 (SC Current)
 	PORTA.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc; ///< Turn off digital buffer for PA2 (SC Voltage)
+	PORTA.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc; ///< Turn off digital buffer for unused PA3 (no floating input current)
 }
@@ -9,35 +9,206 @@
 #include "MT6701Var.h"
 
 /**
- * @brief Reads the angular position from the MT6701 sensor using SSI communication.
+ * @brief Converts a 14-bit MT6701 angle code to 0.01 degree in the reported direction.
+ *
+ * Integer equivalent of (code / 0.4551111111) + 0.5 followed by the optional
+ * direction reversal and the zero offset from the calibration, without floating point.
+ *
+ * @param code 14-bit angle code.
+ * @param channel Sensor, selects direction and zero offset (Calibration).
+ * @return Angle in 0.01 degree (0 to 36000).
+ */
+uint16_t MT6701_Angle(uint16_t code, angleChannel_t channel) {
+	uint16_t angle = ((uint32_t)code * MT6701_ANGLE_MUL + (1UL << (MT6701_ANGLE_SHIFT - 1))) >> MT6701_ANGLE_SHIFT;
+	uint8_t elevation = (channel == Elevation_Angle);
+	uint8_t reversed = Calibration.Flags & (elevation ? CALIBRATION_ELEVATION_REVERSED : CALIBRATION_AZIMUTH_REVERSED);
+	uint16_t zero = Calibration.AngleZero[elevation ? 0 : 1];
+
+	if (reversed) {
+		angle = MT6701_FULL_TURN - angle;
+	}
+	return angle >= zero ? angle - zero : angle + MT6701_FULL_TURN - zero;
+}
+
+/**
+ * @brief Shortest signed difference between two angles, across the 0/360 degree wrap.
+ *
+ * @param to Angle in 0.01 degree.
+ * @param from Angle in 0.01 degree.
+ * @return to - from in 0.01 degree (-18000 to 18000).
+ */
+static int16_t MT6701_AngleDelta(uint16_t to, uint16_t from) {
+	int32_t delta = (int32_t)to - from;
+
+	if (delta > MT6701_FULL_TURN / 2) delta -= MT6701_FULL_TURN;
+	else if (delta < -(MT6701_FULL_TURN / 2)) delta += MT6701_FULL_TURN;
+	return delta;
+}
+
+/**
+ * @brief Unwraps a new good angle into Position and adds it to the averaging window.
+ *
+ * @param sensor Sensor data, Angle still holding the previous good angle.
+ * @param angle New good angle in 0.01 degree.
+ */
+static void MT6701_Accumulate(AngleSensorStatus *sensor, uint16_t angle) {
+	if (sensor->Tracked) {
+		sensor->Position += MT6701_AngleDelta(angle, sensor->Angle); // Shortest path from the last good angle
+	}
+	else {
+		sensor->Position = angle;
+		sensor->Tracked = 1;
+	}
+	sensor->Angle = angle;
+
+	if (!sensor->Samples) {
+		sensor->Reference = sensor->Position; // Offsets are taken from the first sample
+		sensor->DeltaSum = 0;
+	}
+	else if (sensor->Samples == UINT8_MAX) {
+		return; // Window full, drop further samples
+	}
+	else {
+		sensor->DeltaSum += sensor->Position - sensor->Reference;
+	}
+	sensor->Samples++;
+}
+
+/**
+ * @brief Closes the averaging window of a sensor and updates Average, Turns and Velocity.
+ *
+ * Called once per telemetry period. A window without a good sample keeps the previous
+ * average and reports zero velocity; the next good window then measures its change over
+ * the whole time since the last average.
+ *
+ * @param channel Sensor channel.
+ */
+void MT6701_Window(angleChannel_t channel) {
+	AngleSensorStatus *sensor = (channel == Elevation_Angle) ? &MT6701ELEVATION : &MT6701AZIMUTH;
+	uint16_t now = Scheduler_Millis();
+	int32_t sum = sensor->DeltaSum;
+	int32_t average;
+	int32_t turns;
+
+	if (!sensor->Samples) {
+		sensor->Velocity = 0;
+		return;
+	}
+	average = sensor->Reference + (sum + (sum < 0 ? -(sensor->Samples / 2) : sensor->Samples / 2)) / sensor->Samples; // Rounded mean offset
+	turns = average / MT6701_FULL_TURN;
+	if (average % MT6701_FULL_TURN < 0) turns--; // Floor, so Average stays within 0 to 35999
+
+	if (sensor->AverageValid) {
+		uint16_t elapsed = now - sensor->AverageTime;
+		int32_t velocity = (average - sensor->AveragePosition) * 1000 / (elapsed ? elapsed : 1);
+		if (velocity > MT6701_VELOCITY_MAX) velocity = MT6701_VELOCITY_MAX;
+		else if (velocity < -MT6701_VELOCITY_MAX) velocity = -MT6701_VELOCITY_MAX;
+		sensor->Velocity = velocity;
+	}
+	sensor->AveragePosition = average;
+	sensor->Average = average - turns * MT6701_FULL_TURN;
+	sensor->Turns = turns;
+	sensor->AverageTime = now;
+	sensor->AverageValid = 1;
+	sensor->Samples = 0;
+}
+
+/**
+ * @brief Performs one SSI read of an MT6701 sensor.
  *
  * This function initiates an SSI communication session by pulling the chip select (CSN) low,
- * transmitting dummy data to generate a clock signal, and receiving the corresponding data bits.
- * The received data is then processed to extract the angle, magnetic field status, push button status,
+ * clocking 24 bits back-to-back with dummy data, and receiving the corresponding data bits.
+ * The received data is then processed to extract the magnetic field status, push button status,
  * and track status.
+ *
+ * @param channel Sensor to read.
+ * @param sensor Sensor data to update.
+ * @param code Receives the 14-bit angle code.
+ * @return MT6701_STATUS_x flags, 0 if the reading is valid, MT6701_STATUS_ABSENT if no
+ *         sensor drives the data line (an all-ones frame has an invalid field status
+ *         and cannot come from a working MT6701).
  */
-void MT6701_SSI_Angle(angleChannel_t channel) {
-    uint32_t received_data = 0;
+static uint8_t MT6701_SSI_Read(angleChannel_t channel, AngleSensorStatus *sensor, uint16_t *code) {
+    uint8_t rx[3];
     PORTA.OUTCLR = channel; ///< Pull CSN low to start communication   
-    for (uint8_t i = 0; i < 3; i++) { ///< 3 bytes (24 bits) of data
-        USART0_sendChar('o'); ///< Send dummy data (8 bits) for clock generation
-        received_data <<= 8; ///< Shift previous data left by 8 bits
-        received_data |= USART0_readChar(); ///< Read 8 bits of received data and Append current received byte
-    }
+    uint8_t timeout = USART0_Transfer(rx, sizeof(rx)); ///< 3 bytes (24 bits) of data clocked back-to-back
     PORTA.OUTSET = channel; ///< Pull CSN high (USART SPI mode does not have integrated SS control)
-    
-	    // Use a pointer to simplify the logic
-	    AngleSensorStatus *sensor = (channel == Elevation_Angle) ? &MT6701ELEVATION : &MT6701AZIMUTH;
+    uint32_t received_data = ((uint32_t)rx[0] << 16) | ((uint16_t)rx[1] << 8) | rx[2];
+
+	    if (!timeout && received_data == 0xFFFFFF) {
+		    return MT6701_STATUS_ABSENT; // DO stayed at the pulled-up idle level: no sensor driving the line
+	    }
 
 	    // Update sensor data
 	    sensor->CRCError = MT6701CRC(&received_data);  // Verify and remove CRC from received data
 	    sensor->MagneticFieldStatus = received_data & 0x3;  // Extract magnetic field status
 	    sensor->PushButtonStatus = (received_data >> 2) & 0x1;  // Extract push button status
 	    sensor->TrackStatus = (received_data >> 3) & 0x1;  // Extract track status
-	    sensor->Angle = ((double)(received_data >> 4) / 0.4551111111)+0.5;  // Compute angle in degrees
+	    *code = received_data >> 4;
+
+	    if (timeout || sensor->CRCError) {
+		    return MT6701_STATUS_COMM; // Status bits are meaningless too
+	    }
+	    return (sensor->MagneticFieldStatus ? MT6701_STATUS_FIELD : 0) | (sensor->TrackStatus ? MT6701_STATUS_TRACK : 0);
 }
 
-void Swap_Angle_Direction (angleChannel_t channel){
+/**
+ * @brief Reads the angular position from the MT6701 sensor using SSI communication.
+ *
+ * A failed read (CRC error, timeout, magnetic field out of range or loss of track) is
+ * retried immediately up to MT6701_READ_ATTEMPTS times. If every attempt fails, the last
+ * good angle is kept, MT6701_STATUS_HOLD is set and Age keeps counting, so a corrupt
+ * reading is never reported as a real angle.
+ *
+ * A missing sensor is not retried: it is reported as MT6701_STATUS_ABSENT and only
+ * probed again after an exponentially growing number of reads (up to
+ * MT6701_PROBE_MAX_INTERVAL), so it adds no time to the other reads.
+ */
+void MT6701_SSI_Angle(angleChannel_t channel) {
+	// Use a pointer to simplify the logic
 	AngleSensorStatus *sensor = (channel == Elevation_Angle) ? &MT6701ELEVATION : &MT6701AZIMUTH;
-	sensor->Angle = 36000-sensor->Angle;
-}
\ No newline at end of file
+	uint8_t status = 0;
+	uint16_t code;
+
+	if (sensor->ProbeCountdown) { // Absent sensor, not probed this time
+		sensor->ProbeCountdown--;
+		if (sensor->Age < UINT8_MAX) {
+			sensor->Age++;
+		}
+		return;
+	}
+
+	for (uint8_t attempt = 0; attempt < MT6701_READ_ATTEMPTS; attempt++) {
+		status = MT6701_SSI_Read(channel, sensor, &code);
+		if (!status) {
+			MT6701_Accumulate(sensor, MT6701_Angle(code, channel));  // Angle in 0.01 degree, unwrapped into Position
+			sensor->Age = 0;
+			sensor->Status = 0;
+			sensor->ProbeInterval = 0; // Present (again)
+			return;
+		}
+		if (status == MT6701_STATUS_ABSENT) {
+			// Back off: probe again after 1, 2, 4, ... reads
+			sensor->ProbeInterval = sensor->ProbeInterval ? sensor->ProbeInterval << 1 : 1;
+			if (sensor->ProbeInterval > MT6701_PROBE_MAX_INTERVAL) {
+				sensor->ProbeInterval = MT6701_PROBE_MAX_INTERVAL;
+			}
+			sensor->ProbeCountdown = sensor->ProbeInterval;
+			sensor->Status = MT6701_STATUS_ABSENT;
+			if (sensor->Age < UINT8_MAX) {
+				sensor->Age++;
+			}
+			return;
+		}
+		if (status & MT6701_STATUS_COMM) {
+			if (sensor->CommErrors < UINT16_MAX) sensor->CommErrors++;
+		}
+		else if (sensor->FieldErrors < UINT16_MAX) {
+			sensor->FieldErrors++;
+		}
+	}
+	sensor->Status = status | MT6701_STATUS_HOLD; // Keep the last good angle
+	if (sensor->Age < UINT8_MAX) {
+		sensor->Age++;
+	}
+}
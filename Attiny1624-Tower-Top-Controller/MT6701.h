@@ -13,16 +13,96 @@
  * @brief Structure to store MT6701 sensor data.
  *
  * This structure holds the sensor's angle measurement, magnetic field status,
- * push button status, track status, and CRC error flag.
+ * push button status, track status, and CRC error flag of the last read, plus the
+ * validity state: Angle always holds the last good angle, Age counts reads since it
+ * was measured and the counters accumulate failed reads.
  */
 typedef struct {
-    uint16_t Angle;               ///< Measured angle in degrees
+    uint16_t Angle;               ///< Last good angle in 0.01 degree, direction already applied
     uint8_t MagneticFieldStatus;  ///< Magnetic field status (validity flag)
     uint8_t PushButtonStatus;     ///< Push button status (if applicable)
     uint8_t TrackStatus;          ///< Tracking status
     uint8_t CRCError;             ///< CRC error flag (0 = valid, 1 = error detected)
+    uint8_t Status;               ///< MT6701_STATUS_x flags of the last read (0 = good)
+    uint8_t Age;                  ///< Reads since Angle was last updated (saturates at 255)
+    uint16_t CommErrors;          ///< Failed attempts due to CRC error or timeout (saturating)
+    uint16_t FieldErrors;         ///< Failed attempts due to magnetic field or track loss (saturating)
+    uint8_t ProbeInterval;        ///< Reads between probes while the sensor is absent (0 = present)
+    uint8_t ProbeCountdown;       ///< Reads skipped until the next probe of an absent sensor
+    int32_t Position;             ///< Unwrapped position of the last good angle in 0.01 degree
+    uint8_t Tracked;              ///< 1 once Position has been seeded by a good angle
+    int32_t Reference;            ///< Position of the first good sample of the current averaging window
+    int32_t DeltaSum;             ///< Sum of the offsets of the window samples from Reference
+    uint8_t Samples;              ///< Good samples in the current averaging window
+    int32_t AveragePosition;      ///< Unwrapped window average in 0.01 degree
+    uint16_t Average;             ///< Window average in 0.01 degree within one turn (reported angle)
+    int16_t Turns;                ///< Whole turns of AveragePosition (floor), reported with Average
+    uint16_t AverageTime;         ///< Tick (ms) at which Average was computed
+    uint8_t AverageValid;         ///< 1 once a window has produced an average
+    int16_t Velocity;             ///< Angular velocity in 0.01 degree per second
 } AngleSensorStatus;
 
+/**
+ * @brief Read attempts per sensor and cycle: the first read plus immediate retries.
+ *
+ * One attempt takes 24 SSI clocks (48 us at 500 kHz), so the retry budget stays
+ * well below one scheduler tick.
+ */
+#define MT6701_READ_ATTEMPTS 3
+
+/**
+ * @brief Compact sensor status reported in telemetry (4 bits per sensor).
+ */
+#define MT6701_STATUS_HOLD 0x01  ///< All attempts failed, the angle is the last good one
+#define MT6701_STATUS_COMM 0x02  ///< CRC error or SSI timeout
+#define MT6701_STATUS_FIELD 0x04 ///< Magnetic field too strong or too weak
+#define MT6701_STATUS_TRACK 0x08 ///< Loss of track
+#define MT6701_STATUS_ABSENT 0x0F ///< Sensor missing (all bits set, never produced by a read)
+
+/**
+ * @brief Longest interval between probes of an absent sensor, in reads.
+ *
+ * A sensor whose data line stays at its pulled-up idle level for a whole frame is
+ * reported as absent and probed after 1, 2, 4, ... reads up to this value.
+ */
+#define MT6701_PROBE_MAX_INTERVAL 64
+
+/**
+ * @brief Angles are sampled every TASK_ANGLES_PERIOD_MS (Scheduler.h) and averaged over
+ * each telemetry period.
+ *
+ * Every good sample is unwrapped into Position by adding its wrap-aware change from the
+ * previous good sample, so Position counts whole turns in both directions. Reads that
+ * fail leave Position untouched and the next good sample continues from it; the turn
+ * count survives a dropout as long as the sensor turns less than half a turn meanwhile.
+ * The average is taken over Position, so samples on both sides of 0/360 degree average
+ * correctly, and is reported as Turns plus Average (AveragePosition = Turns * 36000 +
+ * Average). The angular velocity is the change between two window averages divided by
+ * the time between them, saturated to MT6701_VELOCITY_MAX.
+ */
+#define MT6701_VELOCITY_MAX INT16_MAX
+
+/**
+ * @brief Angle resolution: one full turn in transmitted units (0.01 degree).
+ */
+#define MT6701_FULL_TURN 36000
+
+/**
+ * @brief Conversion of the 14-bit angle code to 0.01 degree: 36000 / 16384 = 1125 / 512.
+ *
+ * Angle = (code * MT6701_ANGLE_MUL + rounding) >> MT6701_ANGLE_SHIFT, rounded to nearest.
+ */
+#define MT6701_ANGLE_MUL 1125UL
+#define MT6701_ANGLE_SHIFT 9
+
+/**
+ * @brief Default per-channel direction reversal (1 = angle reported as MT6701_FULL_TURN - angle).
+ *
+ * Set to match how each sensor is mounted; a valid calibration record overrides it.
+ */
+#define MT6701_ELEVATION_REVERSED 1
+#define MT6701_AZIMUTH_REVERSED 1
+
 typedef enum {
 	Elevation_Angle = PIN7_bm,
 	Azimuth_Angle = PIN6_bm
@@ -27,13 +27,36 @@
  * - CRCError:
  *   - 0: Normal
  *   - 1: CRC error detected
+ *
+ * - Status: MT6701_STATUS_HOLD until the first good read.
+ *
+ * - Average, Turns, Velocity: 0 until the first averaging window with a good sample.
+ *
+ * - Position: seeded by the first good angle, so the turn count starts at 0 after reset.
  */
 AngleSensorStatus MT6701ELEVATION = {
     .Angle = 0,
     .MagneticFieldStatus = 0,
     .PushButtonStatus = 0,
     .TrackStatus = 0,
-    .CRCError = 0
+    .CRCError = 0,
+    .Status = MT6701_STATUS_HOLD,
+    .Age = 0,
+    .CommErrors = 0,
+    .FieldErrors = 0,
+    .ProbeInterval = 0,
+    .ProbeCountdown = 0,
+    .Position = 0,
+    .Tracked = 0,
+    .Reference = 0,
+    .DeltaSum = 0,
+    .Samples = 0,
+    .AveragePosition = 0,
+    .Average = 0,
+    .Turns = 0,
+    .AverageTime = 0,
+    .AverageValid = 0,
+    .Velocity = 0
 };
 
 AngleSensorStatus MT6701AZIMUTH = {
@@ -41,7 +64,24 @@ AngleSensorStatus MT6701AZIMUTH = {
 	.MagneticFieldStatus = 0,
 	.PushButtonStatus = 0,
 	.TrackStatus = 0,
-	.CRCError = 0
+	.CRCError = 0,
+	.Status = MT6701_STATUS_HOLD,
+	.Age = 0,
+	.CommErrors = 0,
+	.FieldErrors = 0,
+	.ProbeInterval = 0,
+	.ProbeCountdown = 0,
+	.Position = 0,
+	.Tracked = 0,
+	.Reference = 0,
+	.DeltaSum = 0,
+	.Samples = 0,
+	.AveragePosition = 0,
+	.Average = 0,
+	.Turns = 0,
+	.AverageTime = 0,
+	.AverageValid = 0,
+	.Velocity = 0
 };
 
 #endif /* MT6701VAR_H_ */
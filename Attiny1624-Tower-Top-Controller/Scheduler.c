@@ -0,0 +1,105 @@
+/**
+ * @file Scheduler.c
+ * @brief Cooperative scheduler driven by the TCB0 periodic interrupt.
+ * @author Saulius
+ * @date 2025-06-04
+ */
+
+#include "Settings.h"
+
+volatile uint16_t SchedulerTicks = 0; ///< 1 ms ticks since Scheduler_init()
+#if DIAG_ENABLE
+uint32_t SchedulerSleepUs = 0; ///< Time asleep, cleared by the diagnostic task
+#endif
+
+/**
+ * @brief Starts TCB0 as the 1 ms scheduler tick source.
+ *
+ * TCB0 runs in periodic interrupt mode from CLK_PER / 2, so the tick is as accurate
+ * as the main clock (external TCXO).
+ */
+void Scheduler_init() {
+	TCB0.CCMP = SCHEDULER_TCB_TOP; ///< Tick period
+	TCB0.CTRLB = TCB_CNTMODE_INT_gc; ///< Periodic interrupt mode
+	TCB0.INTCTRL = TCB_CAPT_bm; ///< Interrupt on every period
+	TCB0.CTRLA = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm; ///< CLK_PER / 2, start counting
+	set_sleep_mode(SLPCTRL_SMODE_IDLE_gc); ///< Idle sleep keeps timers, ADC and USARTs running
+}
+
+/**
+ * @brief Returns the current tick count (milliseconds, wraps at 65536).
+ */
+uint16_t Scheduler_Millis() {
+	uint16_t ticks;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ticks = SchedulerTicks;
+	}
+	return ticks;
+}
+
+/**
+ * @brief Returns a microsecond timestamp (wraps at 65536 us).
+ *
+ * Combines the tick count with the running TCB0 counter, so no extra timer is needed.
+ * Use differences of two timestamps for timeouts up to about 65 ms.
+ */
+uint16_t Scheduler_Micros() {
+	uint16_t ticks;
+	uint16_t count;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		count = TCB0.CNT;
+		ticks = SchedulerTicks;
+		if ((TCB0.INTFLAGS & TCB_CAPT_bm) && count < SCHEDULER_TCB_TOP / 2) {
+			ticks++; // Counter wrapped but the tick interrupt has not run yet
+		}
+	}
+	return ticks * (uint16_t)(1000000UL / SCHEDULER_TICK_HZ) + count / SCHEDULER_TCB_COUNTS_PER_US;
+}
+
+/**
+ * @brief Runs the task table forever.
+ *
+ * Each due task is released at its fixed schedule (Next += Period), not relative to
+ * when it finished, so periods do not accumulate the run time of other tasks.
+ * When nothing is due the CPU sleeps until the next tick.
+ *
+ * Idle sleep is used rather than standby: TCB0, the TCA0-triggered ADC and both
+ * USART interrupts need CLK_PER, so standby would have to keep the main clock
+ * running for them anyway. Only the CPU and flash are stopped.
+ */
+void Scheduler_Run() {
+	while (1) {
+		uint16_t now = Scheduler_Millis();
+
+		for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+			SchedulerTask *task = &Tasks[i];
+			if ((int16_t)(now - task->Next) >= 0) { // Due (wrap-safe compare)
+				task->Next += task->Period;
+				task->Run();
+			}
+		}
+
+		cli();
+		if (SchedulerTicks == now) { // No tick arrived while tasks were running
+#if DIAG_ENABLE
+			uint16_t sleep_start = Scheduler_Micros(); // Taken before SEI so SEI + SLEEP stay adjacent
+#endif
+			sleep_enable();
+			sei(); // SEI is executed before SLEEP, so the wake-up interrupt cannot be missed
+			sleep_cpu();
+			sleep_disable();
+#if DIAG_ENABLE
+			SchedulerSleepUs += (uint16_t)(Scheduler_Micros() - sleep_start);
+#endif
+		}
+		sei();
+	}
+}
+
+/**
+ * @brief TCB0 periodic interrupt, advances the scheduler tick.
+ */
+ISR(TCB0_INT_vect) {
+	TCB0.INTFLAGS = TCB_CAPT_bm; ///< Clear interrupt flag
+	SchedulerTicks++;
+}
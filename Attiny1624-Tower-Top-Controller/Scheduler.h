@@ -0,0 +1,80 @@
+/**
+ * @file Scheduler.h
+ * @brief Timer driven cooperative scheduler definitions.
+ *
+ * TCB0 generates a 1 ms tick. Every task runs at a fixed period and phase offset
+ * counted in ticks, so task start times do not drift with the run time of other tasks.
+ * The CPU sleeps (idle mode) between ticks.
+ *
+ * @author Saulius
+ * @date 2025-06-04
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/**
+ * @brief Scheduler tick frequency in Hz (1 ms tick).
+ */
+#define SCHEDULER_TICK_HZ 1000
+
+/**
+ * @brief TCB0 compare value for one tick (TCB0 clocked from CLK_PER / 2).
+ */
+#define SCHEDULER_TCB_TOP ((uint16_t)(F_CPU / 2 / SCHEDULER_TICK_HZ - 1))
+
+/**
+ * @brief TCB0 counts per microsecond (TCB0 clocked from CLK_PER / 2).
+ */
+#define SCHEDULER_TCB_COUNTS_PER_US (F_CPU / 2 / 1000000UL)
+
+/**
+ * @brief Task periods and phase offsets in milliseconds (ticks).
+ *
+ * Sampling tasks run at phase 0, telemetry runs later in the same period so it always
+ * starts at a fixed time and sends freshly sampled data. TASK_TELEMETRY_OFFSET_MS must
+ * be longer than the worst-case sampling time.
+ */
+#define TASK_ANGLES_PERIOD_MS 10        ///< MT6701 elevation and azimuth reads (averaged per telemetry period)
+#define TASK_ANGLES_OFFSET_MS 0
+#define TASK_SOLARCELLS_PERIOD_MS 100   ///< Voltage and current measurement with filtering
+#define TASK_SOLARCELLS_OFFSET_MS 0
+#define TASK_ENDSWITCHES_PERIOD_MS 1    ///< Y end switch debounce and event frames
+#define TASK_ENDSWITCHES_OFFSET_MS 0
+#define TASK_TELEMETRY_PERIOD_MS 100    ///< Frame transmission over USART1
+#define TASK_TELEMETRY_OFFSET_MS 50
+
+/**
+ * @brief Number of entries in the task table.
+ */
+#define SCHEDULER_TASKS (5 + DIAG_ENABLE)
+
+/**
+ * @brief One entry of the scheduler task table.
+ */
+typedef struct {
+	void (*Run)(void); ///< Task function
+	uint16_t Period;   ///< Period in ticks
+	uint16_t Next;     ///< Tick of the next release (initialized with the phase offset)
+} SchedulerTask;
+
+/**
+ * @brief Task table, defined in SchedulerVar.h.
+ */
+extern SchedulerTask Tasks[SCHEDULER_TASKS];
+
+/**
+ * @brief Tick counter incremented by the TCB0 interrupt.
+ */
+extern volatile uint16_t SchedulerTicks;
+
+#if DIAG_ENABLE
+/**
+ * @brief Microseconds spent asleep since the last diagnostic frame (duty-cycle report).
+ *
+ * Counts the scheduler idle sleep and the sleep during interrupt-driven SSI transfers.
+ */
+extern uint32_t SchedulerSleepUs;
+#endif
+
+#endif /* SCHEDULER_H_ */
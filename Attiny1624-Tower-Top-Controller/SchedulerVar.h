@@ -0,0 +1,26 @@
+/**
+ * @file SchedulerVar.h
+ * @brief Scheduler task table.
+ *
+ * All task periods and phase offsets are set here (values in Scheduler.h).
+ * Tasks that are due in the same tick run in table order.
+ *
+ * @author Saulius
+ * @date 2025-06-04
+ */
+
+#ifndef SCHEDULERVAR_H_
+#define SCHEDULERVAR_H_
+
+SchedulerTask Tasks[SCHEDULER_TASKS] = {
+	{ .Run = Task_Angles,      .Period = TASK_ANGLES_PERIOD_MS,      .Next = TASK_ANGLES_OFFSET_MS },
+	{ .Run = Task_SolarCells,  .Period = TASK_SOLARCELLS_PERIOD_MS,  .Next = TASK_SOLARCELLS_OFFSET_MS },
+	{ .Run = Task_EndSwitches, .Period = TASK_ENDSWITCHES_PERIOD_MS, .Next = TASK_ENDSWITCHES_OFFSET_MS },
+	{ .Run = Task_Energy,      .Period = TASK_ENERGY_PERIOD_MS,      .Next = TASK_ENERGY_OFFSET_MS },
+	{ .Run = Task_Telemetry,   .Period = TASK_TELEMETRY_PERIOD_MS,   .Next = TASK_TELEMETRY_OFFSET_MS },
+#if DIAG_ENABLE
+	{ .Run = Task_Diagnostics, .Period = TASK_DIAGNOSTICS_PERIOD_MS, .Next = TASK_DIAGNOSTICS_OFFSET_MS }
+#endif
+};
+
+#endif /* SCHEDULERVAR_H_ */
@@ -8,19 +8,30 @@
 #ifndef SETTINGS_H_
 #define SETTINGS_H_
 
-#define F_CPU 20000000
+#ifndef F_CPU
+#define F_CPU 20000000 ///< CPU clock, may be overridden from the compiler command line
+#endif
 
 #include <avr/io.h>
 #include <avr/cpufunc.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #include <stdlib.h>
-#include <stdio.h> 
 #include <string.h> 
 #include <math.h>
+#include "Diagnostics.h"
 #include "FIR.h"
 #include "ADC.h"
+#include "Energy.h"
 #include "USART.h"
 #include "MT6701.h"
+#include "Calibration.h"
+#include "Telemetry.h"
+#include "Yswitches.h"
+#include "Scheduler.h"
 
 /**
  * @brief Initializes general-purpose input/output (GPIO) settings.
@@ -43,20 +54,41 @@ void CLOCK_INHF_clock_init();
 void USART0_init();
 
 /**
- * @brief Sends a character via USART0.
- * @param c Character to be transmitted.
+ * @brief Clocks a block of bytes in from USART0 (SSI), transmitter kept full.
+ * @param rx Receive buffer.
+ * @param length Number of bytes.
+ * @return 0 on success, 1 on timeout.
  */
-void USART0_sendChar(char c);
+uint8_t USART0_Transfer(uint8_t *rx, uint8_t length);
+
+void USART1_init();
 
 /**
- * @brief Reads a character from USART0.
- * @return The received character.
+ * @brief Queues a block of bytes for interrupt-driven transmission on USART1.
+ * @param data Bytes to send.
+ * @param length Number of bytes.
+ * @return 1 if the whole block was queued, 0 if it was dropped because the buffer was full.
  */
-char USART0_readChar();
+uint8_t USART1_write(const char *data, uint8_t length);
 
-void USART1_init();
+/**
+ * @brief Sets the USART1 priority frame, sent at the next block boundary ahead of the queue.
+ * @param data Bytes to send.
+ * @param length Number of bytes (at most USART1_PRIORITY_SIZE).
+ * @return 1 if accepted, 0 if a priority frame is being sent.
+ */
+uint8_t USART1_writePriority(const char *data, uint8_t length);
 
-void USART1_printf(const char *format, ...);
+/**
+ * @brief Queues a null-terminated string for transmission on USART1 (non-blocking).
+ * @param str String to send.
+ */
+void USART1_sendString(const char *str);
+
+/**
+ * @brief Blocks until every queued USART1 byte has been shifted out.
+ */
+void USART1_flush();
 
 /**
  * @brief Verifies and removes CRC from received MT6701 sensor data.
@@ -71,24 +103,180 @@ uint8_t MT6701CRC(uint32_t *data);
 void MT6701_SSI_Angle(angleChannel_t channel);
 
 /**
- * @brief Calculates the CRC-8 CDMA2000 checksum.
- * 
- * This function calculates the CRC-8 CDMA2000 checksum for the provided data using 
- * the CDMA2000 polynomial.
- * 
- * @param data The 64-bit data to calculate the CRC checksum for.
- * @return The calculated CRC-8 checksum value.
+ * @brief Initial value of a running CRC-8/CDMA2000 calculation.
+ */
+#define CRC8_CDMA2000_INIT 0xFF
+
+/**
+ * @brief Feeds one byte into a running CRC-8/CDMA2000 calculation.
+ * @param crc Running CRC value (start with CRC8_CDMA2000_INIT).
+ * @param byte Next data byte.
+ * @return Updated CRC value.
+ */
+uint8_t crc8_cdma2000_update(uint8_t crc, uint8_t byte);
+
+/**
+ * @brief Finishes a running CRC-8/CDMA2000 calculation.
+ * @param crc Running CRC value.
+ * @return The CRC-8 checksum.
  */
-uint8_t crc8_cdma2000(uint64_t data);
+uint8_t crc8_cdma2000_final(uint8_t crc);
 
 uint8_t YEndSwitches();
 
+/**
+ * @brief Samples the start-up end switch state and enables the pin change interrupts.
+ */
+void YEndSwitches_init();
+
+/**
+ * @brief Ends the debounce lockout and sends pending end switch event frames (every tick).
+ */
+void YEndSwitches_Poll();
+
 void ADC0_init();
 
+/**
+ * @brief Returns the latest raw result of a background acquisition step without waiting.
+ * @param step Sequence step (adcSequence_t).
+ * @return Latest 12-bit sample.
+ */
+uint16_t ADC0_Latest(uint8_t step);
+
+/**
+ * @brief Returns the time since the last VDD measurement in milliseconds.
+ */
+uint16_t ADC0_VddAge();
+
+/**
+ * @brief Scales a raw current sample with the tracked VDD.
+ * @param sample 12-bit current sample.
+ * @return Current in 0.01A (zero offset removed).
+ */
+uint16_t ADC0_ScaleCurrent(uint16_t sample);
+
+/**
+ * @brief Scales a raw voltage sample.
+ * @param sample 12-bit voltage sample.
+ * @return Voltage in 0.1V.
+ */
+uint16_t ADC0_ScaleVoltage(uint16_t sample);
+
 void ReadSolarCells(solarrcells_t channel);
 
+/**
+ * @brief Loads the per-unit calibration record or the defaults (before ADC0_init()).
+ */
+void Calibration_init();
+
+/**
+ * @brief Measures the current sensor zero at start-up if enabled in the calibration.
+ */
+void Calibration_AutoZero();
+
+/**
+ * @brief Restores the energy counter from EEPROM.
+ */
+void Energy_init();
+
+/**
+ * @brief Integrates power into the energy counter and saves it periodically.
+ */
+void Task_Energy();
+
 void FIR(solarrcells_t channel);
 
-void Swap_Angle_Direction (angleChannel_t channel);
+/**
+ * @brief Converts a 14-bit MT6701 angle code to 0.01 degree in the configured direction.
+ * @param code 14-bit angle code.
+ * @param channel Sensor channel.
+ * @return Angle in 0.01 degree.
+ */
+uint16_t MT6701_Angle(uint16_t code, angleChannel_t channel);
+
+/**
+ * @brief Closes the angle averaging window and updates the average angle and velocity.
+ * @param channel Sensor channel.
+ */
+void MT6701_Window(angleChannel_t channel);
+
+/**
+ * @brief COBS encodes a block of bytes and appends the 0x00 frame delimiter.
+ * @param in Bytes to encode (at most 253).
+ * @param length Number of input bytes.
+ * @param out Output buffer, at least length + 2 bytes.
+ * @return Number of bytes written, delimiter included.
+ */
+uint8_t COBS_Encode(const uint8_t *in, uint8_t length, uint8_t *out);
+
+/**
+ * @brief Sends one telemetry frame in the format selected by TELEMETRY_FORMAT.
+ * @param frame Field values to transmit.
+ */
+void Telemetry_Send(const TelemetryFrame *frame);
+
+/**
+ * @brief Sets the end switch event frame as the USART1 priority frame.
+ * @param endSwitches Debounced end switch state.
+ * @param delay Microseconds since the switch edge.
+ * @return 1 if accepted, 0 if a priority frame is still being sent.
+ */
+uint8_t Telemetry_SendEvent(uint8_t endSwitches, uint16_t delay);
+
+#if TELEMETRY_CHANGE_DRIVEN
+/**
+ * @brief Decides whether a frame is sent in change-driven mode (deadbands and heartbeat).
+ * @param frame Latest field values.
+ * @return 1 if the frame must be sent, 0 if it is suppressed.
+ */
+uint8_t Telemetry_Due(const TelemetryFrame *frame);
+#endif
+
+/**
+ * @brief Starts the TCB0 1 ms scheduler tick.
+ */
+void Scheduler_init();
+
+/**
+ * @brief Returns the scheduler tick count in milliseconds.
+ */
+uint16_t Scheduler_Millis();
+
+/**
+ * @brief Returns a microsecond timestamp from the scheduler timer (wraps at 65536 us).
+ */
+uint16_t Scheduler_Micros();
+
+/**
+ * @brief Runs the task table forever, sleeping between ticks.
+ */
+void Scheduler_Run();
+
+void Task_Angles();
+
+void Task_SolarCells();
+
+void Task_EndSwitches();
+
+void Task_Telemetry();
+
+#if DIAG_ENABLE
+/**
+ * @brief Adds one stage run time to the diagnostic statistics.
+ * @param stage Timed stage.
+ * @param time Run time in microseconds.
+ */
+void Diag_Record(diagStage_t stage, uint16_t time);
+
+/**
+ * @brief Sends a complete non-telemetry frame in the selected telemetry format.
+ * @param data Frame bytes, CRC included.
+ * @param length Number of bytes.
+ * @param start Start character of the ASCII frame.
+ */
+void Telemetry_SendRaw(const uint8_t *data, uint8_t length, char start);
+
+void Task_Diagnostics();
+#endif
 
 #endif /* SETTINGS_H_ */
\ No newline at end of file
@@ -0,0 +1,75 @@
+/**
+ * @file Tasks.c
+ * @brief Scheduler tasks of the tower top controller.
+ *
+ * Each task covers one part of the former main loop. Periods and phase offsets are
+ * configured in the task table (SchedulerVar.h).
+ *
+ * @author Saulius
+ * @date 2025-06-04
+ */
+
+#include "Settings.h"
+#include "SchedulerVar.h"
+
+/**
+ * @brief Reads both MT6701 sensors (angles are converted in the configured direction).
+ *
+ * Runs faster than the telemetry task; the samples are averaged per telemetry period.
+ */
+void Task_Angles() {
+	DIAG_BEGIN(DIAG_SSI_ELEVATION);
+	MT6701_SSI_Angle(Elevation_Angle); ///< Read MT6701 sensor data
+	DIAG_END(DIAG_SSI_ELEVATION);
+	DIAG_BEGIN(DIAG_SSI_AZIMUTH);
+	MT6701_SSI_Angle(Azimuth_Angle); ///< Read MT6701 sensor data
+	DIAG_END(DIAG_SSI_AZIMUTH);
+}
+
+/**
+ * @brief Measures and filters solar cell voltage and current.
+ */
+void Task_SolarCells() {
+	//ReadSolarCells(Voltage); //uncomment if filtration no needded
+	//ReadSolarCells(Current); //uncomment if filtration no needded
+	DIAG_BEGIN(DIAG_VOLTAGE);
+	FIR(Voltage); //comment if using ReadSolarCells(Voltage);
+	DIAG_END(DIAG_VOLTAGE);
+	DIAG_BEGIN(DIAG_CURRENT);
+	FIR(Current); //comment if using ReadSolarCells(Current);
+	DIAG_END(DIAG_CURRENT);
+}
+
+/**
+ * @brief Debounces the Y end switches and sends their event frames.
+ */
+void Task_EndSwitches() {
+	YEndSwitches_Poll();
+}
+
+/**
+ * @brief Builds and queues one telemetry frame from the latest samples (if due in change-driven mode).
+ */
+void Task_Telemetry() {
+	MT6701_Window(Elevation_Angle); ///< Average the angles sampled since the last frame
+	MT6701_Window(Azimuth_Angle);
+
+	TelemetryFrame frame = {
+		.Elevation = MT6701ELEVATION.Average, ///< Averaged elevation angle with changed direction
+		.Azimuth = MT6701AZIMUTH.Average,     ///< Averaged azimuth angle with changed direction
+		.Voltage = ReadVoltage.Result,      ///< Voltage
+		.Current = ReadCurrent.Result,      ///< Current
+		.EndSwitches = YSwitch.State,       ///< Debounced end switch status
+		.Status = (MT6701ELEVATION.Status << 4) | (MT6701AZIMUTH.Status & 0x0F), ///< Sensor validity
+		.ElevationVelocity = MT6701ELEVATION.Velocity, ///< Elevation angular velocity
+		.AzimuthVelocity = MT6701AZIMUTH.Velocity,     ///< Azimuth angular velocity
+		.Energy = EnergyMeter.Energy,                  ///< Integrated energy
+		.AzimuthTurns = MT6701AZIMUTH.Turns            ///< Unwrapped azimuth turns
+	};
+#if TELEMETRY_CHANGE_DRIVEN
+	if (!Telemetry_Due(&frame)) {
+		return; ///< Nothing moved beyond its deadband and the heartbeat is not due
+	}
+#endif
+	Telemetry_Send(&frame); ///< Send the combined data over USART1 (ASCII or binary, see Telemetry.h)
+}
@@ -0,0 +1,325 @@
+/**
+ * @file Telemetry.c
+ * @brief Serialization of telemetry frames for USART1.
+ *
+ * The binary frame carries the fields of the ASCII frame plus extension fields.
+ * Decoded layout:
+ *
+ * | Byte | Content                                          |
+ * |------|--------------------------------------------------|
+ * | 0    | TELEMETRY_BINARY_VERSION                         |
+ * | 1..8 | E[15:0] A[15:0] V[11:0] C[11:0] Y[3:0], big-endian, top nibble 0 |
+ * | 9    | Sensor status: elevation[7:4], azimuth[3:0] (MT6701_STATUS_x) |
+ * | 10   | Sequence number, +1 per sent frame (wraps)       |
+ * | 11..12 | Elevation velocity, 0.01 degree/s, signed big-endian |
+ * | 13..14 | Azimuth velocity, 0.01 degree/s, signed big-endian   |
+ * | 15..18 | Energy counter, mWh, big-endian (wraps)        |
+ * | 19..20 | Azimuth turns, signed big-endian               |
+ * | 21   | CRC-8/CDMA2000 of bytes 1..20                    |
+ *
+ * In the ASCII frame the CRC-8/CDMA2000 covers exactly the 8 packed field bytes.
+ * The decoded frame is COBS encoded so that 0x00 only appears as the frame delimiter.
+ *
+ * @author Saulius
+ * @date 2025-06-02
+ */
+
+#include "Settings.h"
+
+#if TELEMETRY_RAW_FRAME(TELEMETRY_EVENT_PAYLOAD) > USART1_PRIORITY_SIZE
+#error "The end switch event frame does not fit in USART1_PRIORITY_SIZE"
+#endif
+
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_ASCII
+/**
+ * @brief Nibble to lowercase hex digit lookup (same digits as printf "%x").
+ */
+static const char hex_digits[16] = {
+	'0', '1', '2', '3', '4', '5', '6', '7',
+	'8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+/**
+ * @brief Writes a fixed-width, zero-padded hex field.
+ *
+ * Equivalent to printf "%0<digits>x" for values that fit in the field width.
+ *
+ * @param out Output position.
+ * @param value Field value.
+ * @param digits Field width in hex digits (1 to 4).
+ * @return Output position after the field.
+ */
+static char *Telemetry_PutHex(char *out, uint16_t value, uint8_t digits) {
+	char *end = out + digits;
+
+	while (digits--) {
+		out[digits] = hex_digits[value & 0x0F]; // Fill from the least significant nibble
+		value >>= 4;
+	}
+	return end;
+}
+
+/**
+ * @brief Serializes the legacy `<EEEEAAAAVVVCCCYXX>\r\n` frame without stdio.
+ *
+ * @param frame Field values.
+ * @param crc CRC-8 of the packed fields.
+ * @param out Output buffer of TELEMETRY_ASCII_FRAME bytes.
+ */
+static void Telemetry_PackAscii(const TelemetryFrame *frame, uint8_t crc, char *out) {
+	*out++ = '<';
+	out = Telemetry_PutHex(out, frame->Elevation, 4);   ///< Elevation angle (4 digits)
+	out = Telemetry_PutHex(out, frame->Azimuth, 4);     ///< Azimuth angle (4 digits)
+	out = Telemetry_PutHex(out, frame->Voltage, 3);     ///< Voltage (3 digits)
+	out = Telemetry_PutHex(out, frame->Current, 3);     ///< Current (3 digits)
+	out = Telemetry_PutHex(out, frame->EndSwitches, 1); ///< End switch status (1 digit)
+	out = Telemetry_PutHex(out, crc, 2);                ///< CRC value (2 digits)
+	*out++ = '>';
+	*out++ = '\r';
+	*out = '\n';
+}
+#endif
+
+/**
+ * @brief COBS encodes a block of bytes and appends the 0x00 frame delimiter.
+ *
+ * @param in Bytes to encode (at most 253).
+ * @param length Number of input bytes.
+ * @param out Output buffer, at least length + 2 bytes.
+ * @return Number of bytes written to out, delimiter included.
+ */
+uint8_t COBS_Encode(const uint8_t *in, uint8_t length, uint8_t *out) {
+	uint8_t code_index = 0; ///< Position of the current code byte
+	uint8_t out_index = 1;
+	uint8_t code = 1;       ///< Distance to the next zero
+
+	while (length--) {
+		if (*in) {
+			out[out_index++] = *in;
+			code++;
+		}
+		else {
+			out[code_index] = code; // Zero byte: close the current block
+			code_index = out_index++;
+			code = 1;
+		}
+		in++;
+	}
+	out[code_index] = code;
+	out[out_index++] = 0x00; ///< Frame delimiter
+	return out_index;
+}
+
+/**
+ * @brief Stores one frame byte and feeds it into the running CRC-8.
+ *
+ * @param out Output position.
+ * @param value Byte to store.
+ * @param crc Running CRC-8/CDMA2000.
+ * @return Output position after the byte.
+ */
+static uint8_t *Telemetry_PutByte(uint8_t *out, uint8_t value, uint8_t *crc) {
+	*crc = crc8_cdma2000_update(*crc, value);
+	*out = value;
+	return out + 1;
+}
+
+/**
+ * @brief Packs the frame fields into 8 bytes, feeding each into the running CRC-8.
+ *
+ * Layout (big-endian, top nibble 0): E[15:0] A[15:0] V[11:0] C[11:0] Y[3:0].
+ *
+ * @param frame Field values.
+ * @param out Output buffer of TELEMETRY_FIELD_BYTES bytes.
+ * @param crc Running CRC-8/CDMA2000.
+ * @return Output position after the fields.
+ */
+static uint8_t *Telemetry_PackFields(const TelemetryFrame *frame, uint8_t *out, uint8_t *crc) {
+	out = Telemetry_PutByte(out, frame->Elevation >> 12, crc);
+	out = Telemetry_PutByte(out, frame->Elevation >> 4, crc);
+	out = Telemetry_PutByte(out, (frame->Elevation << 4) | ((frame->Azimuth >> 12) & 0x0F), crc);
+	out = Telemetry_PutByte(out, frame->Azimuth >> 4, crc);
+	out = Telemetry_PutByte(out, (frame->Azimuth << 4) | ((frame->Voltage >> 8) & 0x0F), crc);
+	out = Telemetry_PutByte(out, frame->Voltage, crc);
+	out = Telemetry_PutByte(out, frame->Current >> 4, crc);
+	return Telemetry_PutByte(out, (frame->Current << 4) | (frame->EndSwitches & 0x0F), crc);
+}
+
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+/**
+ * @brief Packs the binary-only extension fields, feeding each byte into the running CRC-8.
+ *
+ * @param frame Field values.
+ * @param out Output buffer of TELEMETRY_EXTENSION_BYTES bytes.
+ * @param crc Running CRC-8/CDMA2000.
+ * @return Output position after the extension fields.
+ */
+static uint8_t *Telemetry_PackExtension(const TelemetryFrame *frame, uint8_t *out, uint8_t *crc) {
+	static uint8_t sequence = 0; ///< Counts every sent frame, dropped ones included
+
+	out = Telemetry_PutByte(out, frame->Status, crc);
+	out = Telemetry_PutByte(out, sequence++, crc);
+	out = Telemetry_PutByte(out, (uint16_t)frame->ElevationVelocity >> 8, crc);
+	out = Telemetry_PutByte(out, frame->ElevationVelocity, crc);
+	out = Telemetry_PutByte(out, (uint16_t)frame->AzimuthVelocity >> 8, crc);
+	out = Telemetry_PutByte(out, frame->AzimuthVelocity, crc);
+	out = Telemetry_PutByte(out, frame->Energy >> 24, crc);
+	out = Telemetry_PutByte(out, frame->Energy >> 16, crc);
+	out = Telemetry_PutByte(out, frame->Energy >> 8, crc);
+	out = Telemetry_PutByte(out, frame->Energy, crc);
+	out = Telemetry_PutByte(out, (uint16_t)frame->AzimuthTurns >> 8, crc);
+	return Telemetry_PutByte(out, frame->AzimuthTurns, crc);
+}
+#endif
+
+#if TELEMETRY_CHANGE_DRIVEN
+/**
+ * @brief Absolute difference of two 16-bit field values.
+ */
+static uint16_t Telemetry_Distance(uint16_t a, uint16_t b) {
+	return a > b ? a - b : b - a;
+}
+
+/**
+ * @brief Angle difference in 0.01 degree, taking the 0/360 degree wrap into account.
+ */
+static uint16_t Telemetry_AngleDistance(uint16_t a, uint16_t b) {
+	uint16_t distance = Telemetry_Distance(a, b);
+	return distance > MT6701_FULL_TURN / 2 ? MT6701_FULL_TURN - distance : distance;
+}
+
+/**
+ * @brief Decides whether a frame is sent in change-driven mode.
+ *
+ * Compares against the last sent frame, not the previous sample, so a slow drift is
+ * still reported once it adds up to the deadband.
+ *
+ * @param frame Latest field values.
+ * @return 1 if the frame must be sent (change or heartbeat), 0 if it is suppressed.
+ */
+uint8_t Telemetry_Due(const TelemetryFrame *frame) {
+	static TelemetryFrame sent;  ///< Last sent field values
+	static uint8_t silence = 0;  ///< Telemetry periods since the last sent frame
+	static uint8_t first = 1;
+
+	if (first
+		|| ++silence >= TELEMETRY_HEARTBEAT_MS / TASK_TELEMETRY_PERIOD_MS
+		|| Telemetry_AngleDistance(frame->Elevation, sent.Elevation) >= TELEMETRY_DEADBAND_ANGLE
+		|| Telemetry_AngleDistance(frame->Azimuth, sent.Azimuth) >= TELEMETRY_DEADBAND_ANGLE
+		|| Telemetry_Distance(frame->Voltage, sent.Voltage) >= TELEMETRY_DEADBAND_VOLTAGE
+		|| Telemetry_Distance(frame->Current, sent.Current) >= TELEMETRY_DEADBAND_CURRENT
+		|| frame->EndSwitches != sent.EndSwitches
+		|| frame->Status != sent.Status) {
+		sent = *frame;
+		silence = 0;
+		first = 0;
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+/**
+ * @brief Sends one telemetry frame over USART1 in the format selected by TELEMETRY_FORMAT.
+ *
+ * @param frame Field values to transmit.
+ */
+void Telemetry_Send(const TelemetryFrame *frame) {
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+	uint8_t payload[TELEMETRY_BINARY_PAYLOAD];
+	uint8_t encoded[TELEMETRY_BINARY_FRAME];
+	uint8_t crc = CRC8_CDMA2000_INIT; ///< Covers the fields and extension fields, not the version byte
+	uint8_t *out = payload;
+
+	DIAG_BEGIN(DIAG_SERIALIZE);
+	*out++ = TELEMETRY_BINARY_VERSION;
+	out = Telemetry_PackFields(frame, out, &crc);
+	out = Telemetry_PackExtension(frame, out, &crc);
+	*out = crc8_cdma2000_final(crc);
+	uint8_t length = COBS_Encode(payload, sizeof(payload), encoded);
+	DIAG_END(DIAG_SERIALIZE);
+	DIAG_BEGIN(DIAG_TX);
+	USART1_write((const char *)encoded, length);
+	DIAG_END(DIAG_TX);
+#else
+	uint8_t fields[TELEMETRY_FIELD_BYTES];
+	char ascii[TELEMETRY_ASCII_FRAME];
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	DIAG_BEGIN(DIAG_SERIALIZE);
+	Telemetry_PackFields(frame, fields, &crc); // Only the CRC is used, the ASCII frame is written from the fields
+	Telemetry_PackAscii(frame, crc8_cdma2000_final(crc), ascii);
+	DIAG_END(DIAG_SERIALIZE);
+	DIAG_BEGIN(DIAG_TX);
+	USART1_write(ascii, sizeof(ascii));
+	DIAG_END(DIAG_TX);
+#endif
+}
+
+/**
+ * @brief Encodes a complete non-telemetry frame (diagnostic or end switch event frame).
+ *
+ * Binary format: the bytes are COBS encoded like a telemetry frame. ASCII format: the
+ * start character, the bytes as hex digits and "\r\n".
+ *
+ * @param data Frame bytes, CRC included.
+ * @param length Number of bytes.
+ * @param start Start character of the ASCII frame (must not be '<').
+ * @param out Output buffer of TELEMETRY_RAW_FRAME(length) bytes.
+ * @return Number of encoded bytes.
+ */
+static uint8_t Telemetry_EncodeRaw(const uint8_t *data, uint8_t length, char start, char *out) {
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+	(void)start; // Only used by the ASCII frame
+	return COBS_Encode(data, length, (uint8_t *)out);
+#else
+	char *begin = out;
+
+	*out++ = start;
+	while (length--) {
+		out = Telemetry_PutHex(out, *data++, 2);
+	}
+	*out++ = '\r';
+	*out++ = '\n';
+	return out - begin;
+#endif
+}
+
+/**
+ * @brief Sets the end switch event frame as the USART1 priority frame.
+ *
+ * Decoded layout: TELEMETRY_EVENT_ID, end switch state, delay from the edge to this
+ * call in microseconds (big-endian), CRC-8/CDMA2000 of the preceding bytes.
+ *
+ * @param endSwitches Debounced end switch state.
+ * @param delay Microseconds since the switch edge.
+ * @return 1 if the frame was accepted, 0 if a priority frame is still being sent.
+ */
+uint8_t Telemetry_SendEvent(uint8_t endSwitches, uint16_t delay) {
+	uint8_t payload[TELEMETRY_EVENT_PAYLOAD];
+	char encoded[TELEMETRY_RAW_FRAME(TELEMETRY_EVENT_PAYLOAD)];
+	uint8_t crc = CRC8_CDMA2000_INIT;
+	uint8_t *out = payload;
+
+	out = Telemetry_PutByte(out, TELEMETRY_EVENT_ID, &crc);
+	out = Telemetry_PutByte(out, endSwitches, &crc);
+	out = Telemetry_PutByte(out, delay >> 8, &crc);
+	out = Telemetry_PutByte(out, delay, &crc);
+	*out = crc8_cdma2000_final(crc);
+	return USART1_writePriority(encoded, Telemetry_EncodeRaw(payload, sizeof(payload), TELEMETRY_EVENT_ASCII_START, encoded));
+}
+
+#if DIAG_ENABLE
+/**
+ * @brief Sends a complete non-telemetry frame (e.g. the diagnostic frame) over USART1.
+ *
+ * @param data Frame bytes, CRC included (at most DIAG_PAYLOAD).
+ * @param length Number of bytes.
+ * @param start Start character of the ASCII frame (must not be '<').
+ */
+void Telemetry_SendRaw(const uint8_t *data, uint8_t length, char start) {
+	char encoded[TELEMETRY_RAW_FRAME(DIAG_PAYLOAD)];
+
+	USART1_write(encoded, Telemetry_EncodeRaw(data, length, start, encoded));
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file Telemetry.h
+ * @brief Telemetry frame formats sent over USART1 to the main controller.
+ *
+ * Two frame formats are available at build time:
+ * - ASCII: the legacy `<EEEEAAAAVVVCCCYXX>\r\n` hex string (21 bytes).
+ * - Binary: a version byte, the packed fields, extension fields and the CRC-8,
+ *   COBS encoded and terminated by a 0x00 delimiter.
+ *
+ * @author Saulius
+ * @date 2025-06-02
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#define TELEMETRY_FORMAT_ASCII 0  ///< Legacy `<EEEEAAAAVVVCCCYXX>` hex frame
+#define TELEMETRY_FORMAT_BINARY 1 ///< COBS encoded binary frame
+
+/**
+ * @brief Selects the frame format sent by Telemetry_Send().
+ */
+#ifndef TELEMETRY_FORMAT
+#define TELEMETRY_FORMAT TELEMETRY_FORMAT_ASCII ///< May be overridden from the compiler command line
+#endif
+
+/**
+ * @brief Sends a frame only when a field has changed beyond its deadband (1) or every period (0).
+ *
+ * In change-driven mode a frame is still sent after TELEMETRY_HEARTBEAT_MS without one.
+ * The binary sequence number counts sent frames, so the receiver can tell suppressed
+ * frames (no gap) from lost ones (gap).
+ */
+#ifndef TELEMETRY_CHANGE_DRIVEN
+#define TELEMETRY_CHANGE_DRIVEN 0 ///< May be overridden from the compiler command line
+#endif
+
+/**
+ * @brief Longest silence in change-driven mode, in milliseconds (multiple of TASK_TELEMETRY_PERIOD_MS,
+ * at most 255 periods).
+ */
+#define TELEMETRY_HEARTBEAT_MS 1000
+
+/**
+ * @brief Change against the last sent frame that triggers a new frame.
+ *
+ * A field triggers when it differs by at least its deadband. End switches and sensor
+ * status trigger on any change.
+ */
+#define TELEMETRY_DEADBAND_ANGLE 10   ///< Elevation and azimuth, 0.01 degree (wrap-aware)
+#define TELEMETRY_DEADBAND_VOLTAGE 4  ///< Voltage units
+#define TELEMETRY_DEADBAND_CURRENT 4  ///< Current units
+
+/**
+ * @brief Number of packed field bytes covered by the CRC-8.
+ */
+#define TELEMETRY_FIELD_BYTES 8
+
+/**
+ * @brief ASCII frame length: `<`, 17 hex digits, `>` and "\r\n".
+ */
+#define TELEMETRY_ASCII_FRAME 21
+
+/**
+ * @brief Binary frame layout version (first byte of the decoded frame).
+ *
+ * Increase whenever the binary field layout changes.
+ */
+#define TELEMETRY_BINARY_VERSION 6
+
+/**
+ * @brief Fields carried only by the binary frame, after the packed field bytes.
+ *
+ * Version 2: sensor status byte.
+ * Version 3: frame sequence number after the status byte.
+ * Version 4: elevation and azimuth angular velocity after the sequence number.
+ * Version 5: energy counter after the velocities.
+ * Version 6: azimuth turn counter after the energy counter.
+ */
+#define TELEMETRY_EXTENSION_BYTES 12
+
+/**
+ * @brief Decoded binary frame length: version, packed field bytes, extension bytes and CRC-8.
+ */
+#define TELEMETRY_BINARY_PAYLOAD (1 + TELEMETRY_FIELD_BYTES + TELEMETRY_EXTENSION_BYTES + 1)
+
+/**
+ * @brief Encoded binary frame length: COBS adds one overhead byte, plus the 0x00 delimiter.
+ */
+#define TELEMETRY_BINARY_FRAME (TELEMETRY_BINARY_PAYLOAD + 2)
+
+/**
+ * @brief Encoded length of a non-telemetry frame of `length` decoded bytes.
+ *
+ * Binary: COBS overhead byte and delimiter. ASCII: start character, two hex digits per
+ * byte and "\r\n".
+ */
+#if TELEMETRY_FORMAT == TELEMETRY_FORMAT_BINARY
+#define TELEMETRY_RAW_FRAME(length) ((length) + 2)
+#else
+#define TELEMETRY_RAW_FRAME(length) (1 + (length) * 2 + 2)
+#endif
+
+/**
+ * @brief End switch event frame, sent as a USART1 priority frame on every debounced change.
+ *
+ * The first byte is never used as a telemetry version; in ASCII mode the frame starts
+ * with TELEMETRY_EVENT_ASCII_START instead of '<'.
+ */
+#define TELEMETRY_EVENT_ID 0xE1
+#define TELEMETRY_EVENT_ASCII_START '!'
+#define TELEMETRY_EVENT_PAYLOAD 5 ///< ID, end switch state, delay (2 bytes), CRC-8
+
+/**
+ * @brief Field values carried by one telemetry frame.
+ */
+typedef struct {
+	uint16_t Elevation;  ///< Elevation angle, 0.01 degree
+	uint16_t Azimuth;    ///< Azimuth angle, 0.01 degree
+	uint16_t Voltage;    ///< Solar string voltage (12 bits used)
+	uint16_t Current;    ///< Solar string current (12 bits used)
+	uint8_t EndSwitches; ///< Y end switch state (4 bits used)
+	uint8_t Status;      ///< MT6701 status: elevation in the high nibble, azimuth in the low nibble (binary only)
+	int16_t ElevationVelocity; ///< Elevation angular velocity, 0.01 degree per second (binary only)
+	int16_t AzimuthVelocity;   ///< Azimuth angular velocity, 0.01 degree per second (binary only)
+	uint32_t Energy;           ///< Solar string energy counter, mWh (binary only)
+	int16_t AzimuthTurns;      ///< Whole azimuth turns, position = turns * 360 degree + Azimuth (binary only)
+} TelemetryFrame;
+
+#endif /* TELEMETRY_H_ */
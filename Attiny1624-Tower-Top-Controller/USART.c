@@ -8,51 +8,124 @@
 #include "Settings.h"
 #include "USARTVar.h"
 
+#if SSI_USE_INTERRUPT
+static uint8_t *ssi_rx;                  ///< Receive buffer of the running transfer
+static uint8_t ssi_received;             ///< Bytes received so far
+static uint8_t ssi_sent;                 ///< Dummy bytes written so far
+static uint8_t ssi_length;               ///< Transfer length
+static volatile uint8_t ssi_busy = 0;    ///< 1 while a transfer is running
+#endif
+
 /**
  * @brief Initializes USART0 for SPI communication.
  *
- * This function configures USART0 to operate in SPI master mode with a baud rate of 500 kbps.
+ * This function configures USART0 to operate in SPI master mode with a clock of SSI_CLOCK_HZ.
  * It enables the receiver (MISO) and transmitter (for sending dummy data), and sets
  * the SPI mode with data sampling on the trailing edge.
  */
 void USART0_init() {
-    USART0.BAUD = (uint16_t)USART0_BAUD_RATE(500000); ///< Set baud rate to 0.5 Mbps
+    USART0.BAUD = (uint16_t)USART0_BAUD_RATE(SSI_CLOCK_HZ); ///< Set SSI clock
     USART0.CTRLB = USART_RXEN_bm | USART_TXEN_bm; ///< Enable RX as MISO, TX for dummy data sending
     USART0.CTRLC = USART_CMODE_MSPI_gc | USART_UCPHA_bm; ///< Configure as Host SPI, data sampled on the trailing edge
 }
 
 /**
- * @brief Sends a character via USART0.
+ * @brief Clocks a block of bytes in from USART0 with the transmitter kept full.
+ *
+ * Dummy bytes are written as soon as the double-buffered transmitter has room (at most
+ * two bytes ahead of the receiver, so the receive FIFO cannot overflow), so all bits are
+ * clocked back-to-back without gaps between bytes.
  *
- * @param c Character to be transmitted.
+ * With SSI_USE_INTERRUPT the receive interrupt collects the bytes and refills the
+ * transmitter, and the CPU sleeps (idle) until the transfer is complete.
  *
- * This function waits for the data register to be empty before transmitting
- * the provided character.
+ * @param rx Receive buffer.
+ * The transfer is aborted after SSI_TIMEOUT_US(length) microseconds, measured with the
+ * scheduler timer. In interrupt mode the timeout is checked whenever the CPU wakes up,
+ * i.e. at the latest on the next scheduler tick.
+ *
+ * @param length Number of bytes to clock in (1 to 255).
+ * @return 0 on success, 1 on timeout.
  */
-void USART0_sendChar(char c) {
-    while (!(USART0.STATUS & USART_DREIF_bm)); ///< Wait for data register to be empty
-    USART0.TXDATAL = c; ///< Send character
+uint8_t USART0_Transfer(uint8_t *rx, uint8_t length) {
+    while (USART0.STATUS & USART_RXCIF_bm) { // Drop stale received data
+        (void)USART0.RXDATAL;
+    }
+#if SSI_USE_INTERRUPT
+    uint16_t timeout = SSI_TIMEOUT_US(length);
+    uint16_t start = Scheduler_Micros();
+
+    ssi_rx = rx;
+    ssi_length = length;
+    ssi_received = 0;
+    ssi_sent = (length > 1) ? 2 : 1; // Fill the transmit buffer and the shift register
+    ssi_busy = 1;
+    USART0.TXDATAL = SSI_DUMMY_BYTE;
+    if (length > 1) {
+        USART0.TXDATAL = SSI_DUMMY_BYTE;
+    }
+    USART0.CTRLA |= USART_RXCIE_bm; ///< Collect bytes in the receive interrupt
+
+    cli();
+    while (ssi_busy) {
+        if ((uint16_t)(Scheduler_Micros() - start) >= timeout) { // Timeout condition (checked on every wake-up)
+            USART0.CTRLA &= ~USART_RXCIE_bm;
+            ssi_busy = 0;
+            sei();
+            return 1;
+        }
+#if DIAG_ENABLE
+        uint16_t sleep_start = Scheduler_Micros(); // Counted like the scheduler idle sleep
+#endif
+        sleep_enable();
+        sei(); // SEI is executed before SLEEP, so the completing interrupt cannot be missed
+        sleep_cpu();
+        sleep_disable();
+        cli();
+#if DIAG_ENABLE
+        SchedulerSleepUs += (uint16_t)(Scheduler_Micros() - sleep_start);
+#endif
+    }
+    sei();
+    return 0;
+#else
+    uint8_t sent = 0;
+    uint8_t received = 0;
+    uint16_t timeout = SSI_TIMEOUT_US(length);
+    uint16_t start = Scheduler_Micros(); // Hardware timer based timeout
+
+    while (received < length) {
+        if (sent < length && (uint8_t)(sent - received) < 2 && (USART0.STATUS & USART_DREIF_bm)) {
+            USART0.TXDATAL = SSI_DUMMY_BYTE; ///< Send dummy data (8 bits) for clock generation
+            sent++;
+        }
+        if (USART0.STATUS & USART_RXCIF_bm) {
+            rx[received++] = USART0.RXDATAL; ///< Store received byte
+        }
+        else if ((uint16_t)(Scheduler_Micros() - start) >= timeout) { // Timeout condition
+            return 1;
+        }
+    }
+    return 0;
+#endif
 }
 
+#if SSI_USE_INTERRUPT
 /**
- * @brief Reads a single character from USART0.
- * 
- * This function waits for a character to be received, and if no character is received within the timeout 
- * period, it sets a warning flag. 
- * 
- * @return The received character.
+ * @brief USART0 receive complete interrupt, collects SSI bytes and keeps the transmitter full.
  */
-char USART0_readChar() {
-    USART0.STATUS = USART_RXCIF_bm; // Clear buffer before reading
-    uint32_t timeout_counter = TIMEOUT_COUNTER; // Set a timeout counter
-    while (!(USART0.STATUS & USART_RXCIF_bm)) { // Wait for data to be received
-        if (--timeout_counter == 0) { // Timeout condition
-           // Status.warning = 1; // Set warning if timeout occurs
-            break;
-        }
+ISR(USART0_RXC_vect) {
+    ssi_rx[ssi_received++] = USART0.RXDATAL; ///< Store received byte (clears the flag)
+    if (ssi_sent < ssi_length) {
+        USART0.TXDATAL = SSI_DUMMY_BYTE; ///< Next dummy byte, one byte is still shifting
+        ssi_sent++;
+    }
+    if (ssi_received >= ssi_length) {
+        USART0.CTRLA &= ~USART_RXCIE_bm; ///< Transfer complete
+        ssi_busy = 0;
     }
-    return USART0.RXDATAL; // Return received character
 }
+#endif
 
 
 /**
@@ -67,44 +140,138 @@ void USART1_init() {
 	USART1.CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc; // Configure for 8-bit, no parity, 1 stop bit, asynchronous mode
 }
 
+/**
+ * @brief Queues a block of bytes for transmission via USART1.
+ *
+ * The bytes are copied into the transmit ring buffer behind a length byte and the data
+ * register empty interrupt is enabled; the function returns immediately. A block that
+ * does not fit is dropped as a whole (and counted in USART1TX.overflowCount) so the
+ * receiver never sees a truncated frame.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes to send.
+ * @return 1 if the block was queued, 0 if it was dropped.
+ */
+uint8_t USART1_write(const char *data, uint8_t length) {
+	uint8_t head = USART1TX.head;
+	uint8_t space = (USART1TX.tail - head - 1) & USART1_TX_BUFFER_MASK; // Free slots, one kept empty
+
+	if (!length) {
+		return 1; // Nothing to send (a zero length byte would end the block early)
+	}
+	if (length >= space) {
+		USART1TX.overflowCount++; // Not enough room for the length byte and the block, drop it
+		return 0;
+	}
+	USART1TX.buffer[head] = length;
+	head = (head + 1) & USART1_TX_BUFFER_MASK;
+	while (length--) {
+		USART1TX.buffer[head] = *data++;
+		head = (head + 1) & USART1_TX_BUFFER_MASK;
+	}
+	USART1TX.head = head; // Publish the new bytes to the interrupt
+	USART1.CTRLA |= USART_DREIE_bm; // Start (or keep) the interrupt-driven transmission
+	return 1;
+}
+
+/**
+ * @brief Sets the priority frame, sent at the next block boundary ahead of the queue.
+ *
+ * A pending priority frame that has not started yet is replaced, so only the newest
+ * one is sent. While a priority frame is being transmitted nothing is changed.
+ *
+ * @param data Bytes to send.
+ * @param length Number of bytes (1 to USART1_PRIORITY_SIZE).
+ * @return 1 if the frame was accepted, 0 if a priority frame is in progress or it is too long.
+ */
+uint8_t USART1_writePriority(const char *data, uint8_t length) {
+	uint8_t accepted = 0;
+
+	if (!length || length > USART1_PRIORITY_SIZE) {
+		return 0;
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (!USART1TX.priorityIndex) { // Not started, safe to (re)write
+			memcpy(USART1TX.priority, data, length);
+			USART1TX.priorityLength = length;
+			USART1.CTRLA |= USART_DREIE_bm;
+			accepted = 1;
+		}
+	}
+	return accepted;
+}
+
 /**
  * @brief Sends a single character via USART1.
  * 
- * This function waits until the USART1 data register is empty and then transmits a character.
+ * The character is queued in the transmit buffer and sent in the background.
  * 
  * @param c The character to send.
  */
 void USART1_sendChar(char c) {
-	while (!(USART1.STATUS & USART_DREIF_bm)); // Wait for data register to be empty
-	USART1.TXDATAL = c; // Send character
+	USART1_write(&c, 1);
 }
 
 /**
  * @brief Sends a string via USART1.
  * 
- * This function sends each character of the string one by one using the USART1_sendChar function.
+ * The string is queued in the transmit buffer in one piece; the function does not
+ * wait for the transmission to finish.
  * 
  * @param str The string to send.
  */
-void USART1_sendString(char *str) {
-	for (size_t i = 0; i < strlen(str); i++) {
-		USART1_sendChar(str[i]); // Send each character
+void USART1_sendString(const char *str) {
+	USART1_write(str, strlen(str));
+}
+
+/**
+ * @brief Waits until all queued USART1 data has been transmitted.
+ *
+ * Returns once the ring buffer is empty and the last byte has left the shift register
+ * (TXCIF), e.g. before changing the baud rate or entering a deep sleep mode.
+ */
+void USART1_flush() {
+	while (USART1TX.head != USART1TX.tail || USART1TX.priorityLength); // Wait for the interrupt to drain the buffers
+	if (USART1TX.inFlight) {
+		while (!(USART1.STATUS & USART_TXCIF_bm)); // Wait for the last byte to be shifted out
+		USART1TX.inFlight = 0;
 	}
 }
 
 /**
- * @brief Sends a formatted string via USART1.
- * 
- * This function formats the input string with the provided arguments and sends it via USART1.
- * 
- * @param format The format string.
- * @param ... The arguments to be formatted into the string.
+ * @brief USART1 data register empty interrupt.
+ *
+ * Loads the next byte into the transmit data register and disables itself once both
+ * buffers are empty. At a block boundary a pending priority frame goes first, so its
+ * latency is at most the rest of the block being sent.
  */
-void USART1_printf(const char *format, ...) {
-	char buffer[30]; // Temporary buffer for formatted message
-	va_list args;
-	va_start(args, format);
-	vsnprintf(buffer, sizeof(buffer), format, args); // Format the message into the buffer
-	va_end(args);
-	USART1_sendString(buffer); // Use USART1 for sending
-}
\ No newline at end of file
+ISR(USART1_DRE_vect) {
+	uint8_t tail = USART1TX.tail;
+	uint8_t data;
+
+	if (!USART1TX.remaining && USART1TX.priorityLength) { // Block boundary: priority frame first
+		uint8_t index = USART1TX.priorityIndex;
+		data = USART1TX.priority[index++];
+		if (index == USART1TX.priorityLength) {
+			USART1TX.priorityLength = 0; // Done
+			index = 0;
+		}
+		USART1TX.priorityIndex = index;
+	}
+	else {
+		if (tail == USART1TX.head) {
+			USART1.CTRLA &= ~USART_DREIE_bm; // Nothing left to send
+			return;
+		}
+		if (!USART1TX.remaining) {
+			USART1TX.remaining = USART1TX.buffer[tail]; // Length byte of the next block
+			tail = (tail + 1) & USART1_TX_BUFFER_MASK;
+		}
+		data = USART1TX.buffer[tail];
+		USART1TX.tail = (tail + 1) & USART1_TX_BUFFER_MASK;
+		USART1TX.remaining--;
+	}
+	USART1.STATUS = USART_TXCIF_bm; // Clear transmit complete flag, used by USART1_flush()
+	USART1.TXDATAL = data;
+	USART1TX.inFlight = 1;
+}
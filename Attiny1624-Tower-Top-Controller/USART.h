@@ -9,28 +9,75 @@
 #ifndef USART_H_
 #define USART_H_
 
+/**
+ * @brief SSI clock for the MT6701 sensors (USART0 in host SPI mode).
+ *
+ * USART0 can clock at most F_CPU / 2 (10 MHz at 20 MHz), which is below the MT6701
+ * SSI limit; long sensor cables may need a lower value.
+ */
+#define SSI_CLOCK_HZ 500000
+
+#if SSI_CLOCK_HZ > (F_CPU / 2)
+#error "SSI_CLOCK_HZ exceeds the USART0 host SPI limit of F_CPU / 2"
+#endif
+
+/**
+ * @brief 1 = SSI transfers complete in the USART0 receive interrupt and the CPU sleeps
+ * while waiting, 0 = polled transfers.
+ */
+#define SSI_USE_INTERRUPT 1
+
+/**
+ * @brief SSI transfer timeout in microseconds: twice the nominal transfer time of
+ * `length` bytes plus SSI_TIMEOUT_MARGIN_US.
+ */
+#define SSI_TIMEOUT_MARGIN_US 20
+#define SSI_TIMEOUT_US(length) ((uint16_t)((length) * 8UL * 1000000UL / SSI_CLOCK_HZ * 2 + SSI_TIMEOUT_MARGIN_US))
+
+/**
+ * @brief Dummy byte clocked out to generate the SSI clock.
+ */
+#define SSI_DUMMY_BYTE 'o'
+
 /**
  * @brief Macro to calculate USART baud rate in synchronous mode as Host SPI.
  * @param BAUD_RATE Desired baud rate.
  */
-
 #define USART0_BAUD_RATE(BAUD_RATE) ((float)(F_CPU / (2 * (float)BAUD_RATE / 64)) + 0.5) //synchronous mode as Host SPI
 #define USART1_BAUD_RATE(BAUD_RATE) ((float)(F_CPU * 64 / (8 *(float)BAUD_RATE)) + 0.5) // double speed
 
-#define PrintfBufferSize 30 //printf buffer size for USART1_printf()
+/**
+ * @brief Size of the USART1 transmit ring buffer in bytes.
+ *
+ * Must be a power of two (index wrapping is done with a mask) and no larger than 256.
+ * One slot is always kept free to tell a full buffer from an empty one, so up to
+ * USART1_TX_BUFFER_SIZE - 1 bytes can be queued. Every block written with
+ * USART1_write() takes one extra byte for its length. 64 bytes hold two ASCII frames,
+ * 128 bytes also hold the ASCII diagnostic frame.
+ */
+#if DIAG_ENABLE
+#define USART1_TX_BUFFER_SIZE 128
+#else
+#define USART1_TX_BUFFER_SIZE 64
+#endif
+#define USART1_TX_BUFFER_MASK (USART1_TX_BUFFER_SIZE - 1)
+
+#if (USART1_TX_BUFFER_SIZE & USART1_TX_BUFFER_MASK) || (USART1_TX_BUFFER_SIZE > 256)
+#error "USART1_TX_BUFFER_SIZE must be a power of two not larger than 256"
+#endif
 
 /**
- * @brief Maximum count for consecutive errors before marking the system as faulty.
+ * @brief Size of the USART1 priority frame buffer in bytes.
+ *
+ * A priority frame is sent at the next block boundary, ahead of everything queued
+ * in the ring buffer.
  */
-#define CountForError 10
+#define USART1_PRIORITY_SIZE 16
 
 /**
- * @brief Timeout counter value for operations.
- * 
- * This constant defines the timeout threshold for operations. If the counter 
- * exceeds this value, it indicates a timeout has occurred.
+ * @brief Maximum count for consecutive errors before marking the system as faulty.
  */
-#define TIMEOUT_COUNTER 40000 ///< Timeout counter value for operations
+#define CountForError 10
 
 /**
  * @brief Structure to hold communication status.
@@ -52,4 +99,29 @@ typedef struct {
  */
 extern Communication Status;
 
+/**
+ * @brief USART1 transmit ring buffer drained by the data register empty (DRE) interrupt.
+ *
+ * The main loop only writes `head`, the DRE interrupt only writes `tail`, so both sides
+ * can work on the buffer without disabling interrupts. Each block is stored behind a
+ * length byte, so the interrupt knows where frames end and can insert the priority
+ * frame between two blocks without splitting one.
+ */
+typedef struct {
+	uint8_t buffer[USART1_TX_BUFFER_SIZE]; ///< Length-prefixed queued blocks
+	volatile uint8_t head;                 ///< Next free slot (written by USART1_write)
+	volatile uint8_t tail;                 ///< Next byte to transmit (written by the DRE interrupt)
+	volatile uint8_t inFlight;             ///< 1 while the last loaded byte may still be shifting out
+	uint16_t overflowCount;                ///< Messages dropped because the buffer was full
+	uint8_t remaining;                     ///< Bytes left of the block being sent (DRE interrupt only)
+	char priority[USART1_PRIORITY_SIZE];   ///< Priority frame
+	volatile uint8_t priorityLength;       ///< Priority frame length, 0 = none pending
+	volatile uint8_t priorityIndex;        ///< Priority bytes already sent (> 0 = in progress)
+} USART1_TX_BUFFER;
+
+/**
+ * @brief Global USART1 transmit queue.
+ */
+extern USART1_TX_BUFFER USART1TX;
+
 #endif /* USART_H_ */
\ No newline at end of file
@@ -25,4 +25,19 @@ Communication Status = {
     .warning = 0          ///< Warning flag, initialized to 0 (no warning).
 };
 
+/**
+ * @brief USART1 transmit queue, empty at startup.
+ */
+USART1_TX_BUFFER USART1TX = {
+	.buffer = {0},      ///< Transmit data
+	.head = 0,          ///< Write index
+	.tail = 0,          ///< Read index
+	.inFlight = 0,      ///< Nothing transmitted yet
+	.overflowCount = 0, ///< No dropped messages
+	.remaining = 0,     ///< At a block boundary
+	.priority = {0},    ///< Priority frame data
+	.priorityLength = 0,///< No priority frame pending
+	.priorityIndex = 0
+};
+
 #endif /* USARTVAR_H_ */
\ No newline at end of file
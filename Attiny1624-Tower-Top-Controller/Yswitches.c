@@ -5,7 +5,75 @@
  *  Author: Saulius
  */ 
  #include "Settings.h"
+ #include "YswitchesVar.h"
 
  uint8_t YEndSwitches(){
-	return (!(PORTA.IN & PIN5_bm)) | ((!(PORTA.IN & PIN4_bm)) << 1); // Checking Y min and max values (PB0 and PA2 values) and it will be 0,1,2,3
- } 
\ No newline at end of file
+	return (!(PORTA.IN & YSWITCH_MIN_PIN)) | ((!(PORTA.IN & YSWITCH_MAX_PIN)) << 1); // Checking Y min and max values (PA5 and PA4 values) and it will be 0,1,2,3
+ }
+
+/**
+ * @brief Takes a new end switch state as a debounced change and queues its event frame.
+ *
+ * Called with interrupts disabled (pin change interrupt or atomic block). The frame is
+ * queued at once; only while a priority frame is still being transmitted it is left
+ * pending for YEndSwitches_Poll().
+ *
+ * @param state New state from YEndSwitches().
+ */
+static void YEndSwitches_Change(uint8_t state) {
+	YSwitch.State = state;
+	YSwitch.EdgeTime = Scheduler_Micros();
+	YSwitch.Events++;
+	YSwitch.Lockout = YSWITCH_DEBOUNCE_MS;
+	YSwitch.Pending = !Telemetry_SendEvent(state, 0);
+}
+
+/**
+ * @brief Samples the start-up state and enables the pin change interrupts.
+ */
+void YEndSwitches_init() {
+	YSwitch.State = YEndSwitches();
+	PORTA.INTFLAGS = YSWITCH_PINS; ///< Drop edges seen before start-up
+	PORTA.PIN4CTRL = PORT_PULLUPEN_bm | PORT_ISC_BOTHEDGES_gc; ///< Y MAX, interrupt on both edges
+	PORTA.PIN5CTRL = PORT_PULLUPEN_bm | PORT_ISC_BOTHEDGES_gc; ///< Y MIN, interrupt on both edges
+}
+
+/**
+ * @brief Debounce timing and event frame retries, run every tick.
+ *
+ * When the lockout ends the pins are sampled again, so a release (or a bounce that
+ * settled in the other state) during the lockout is still reported. A change that could
+ * not be queued because a priority frame was still going out is retried on every tick;
+ * the retry runs with interrupts disabled so it cannot replace a newer change queued by
+ * the pin change interrupt meanwhile.
+ */
+void YEndSwitches_Poll() {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (YSwitch.Lockout && !--YSwitch.Lockout) {
+			uint8_t state = YEndSwitches();
+			if (state != YSwitch.State) {
+				YEndSwitches_Change(state);
+			}
+		}
+		if (YSwitch.Pending) {
+			YSwitch.Pending = !Telemetry_SendEvent(YSwitch.State, Scheduler_Micros() - YSwitch.EdgeTime);
+		}
+	}
+}
+
+/**
+ * @brief PORTA pin change interrupt for the Y end switches.
+ *
+ * The first edge after the lockout is reported at once: its event frame is built and
+ * set as the USART1 priority frame here (about 20 us at 20 MHz), so it goes out at the
+ * next block boundary. Bounces are ignored until YEndSwitches_Poll() ends the lockout.
+ */
+ISR(PORTA_PORT_vect) {
+	PORTA.INTFLAGS = YSWITCH_PINS; ///< Clear interrupt flags
+	if (!YSwitch.Lockout) {
+		uint8_t state = YEndSwitches();
+		if (state != YSwitch.State) {
+			YEndSwitches_Change(state);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+/**
+ * @file Yswitches.h
+ * @brief Y axis end switch (Y MIN on PA5, Y MAX on PA4) event handling.
+ *
+ * Both inputs raise a pin change interrupt on every edge. The first edge is taken at
+ * once and timestamped; further edges are ignored for YSWITCH_DEBOUNCE_MS, after which
+ * the pins are sampled again to catch the settled state. Every debounced change is sent
+ * as an end switch event frame ahead of the queued telemetry; the pin change interrupt
+ * queues it directly, so it reaches the line after the rest of the block being
+ * transmitted (at most one telemetry frame) and the byte already in the transmitter.
+ *
+ * @author Saulius
+ * @date 2025-06-12
+ */
+
+#ifndef YSWITCHES_H_
+#define YSWITCHES_H_
+
+/**
+ * @brief End switch input pins on PORTA.
+ */
+#define YSWITCH_MIN_PIN PIN5_bm
+#define YSWITCH_MAX_PIN PIN4_bm
+#define YSWITCH_PINS (YSWITCH_MIN_PIN | YSWITCH_MAX_PIN)
+
+/**
+ * @brief Lockout after an accepted edge in milliseconds (scheduler ticks).
+ */
+#define YSWITCH_DEBOUNCE_MS 5
+
+/**
+ * @brief Debounced end switch state shared with the pin change interrupt.
+ */
+typedef struct {
+	volatile uint8_t State;    ///< Debounced state: bit 0 Y MIN, bit 1 Y MAX (1 = active)
+	volatile uint8_t Lockout;  ///< Ticks left in which edges are ignored
+	volatile uint8_t Pending;  ///< 1 while the last change waits for a priority frame to finish
+	volatile uint16_t EdgeTime;///< Scheduler_Micros() timestamp of the last change
+	volatile uint16_t Events;  ///< Debounced changes since start-up (wraps, reported in the diagnostic frame)
+} YSWITCH_STATE;
+
+/**
+ * @brief End switch state, defined in YswitchesVar.h.
+ */
+extern YSWITCH_STATE YSwitch;
+
+#endif /* YSWITCHES_H_ */
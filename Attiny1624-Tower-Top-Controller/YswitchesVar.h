@@ -0,0 +1,22 @@
+/**
+ * @file YswitchesVar.h
+ * @brief End switch state.
+ *
+ * State is sampled in YEndSwitches_init(); no event is sent for the start-up state.
+ *
+ * @author Saulius
+ * @date 2025-06-12
+ */
+
+#ifndef YSWITCHESVAR_H_
+#define YSWITCHESVAR_H_
+
+YSWITCH_STATE YSwitch = {
+	.State = 0,
+	.Lockout = 0,
+	.Pending = 0,
+	.EdgeTime = 0,
+	.Events = 0
+};
+
+#endif /* YSWITCHESVAR_H_ */
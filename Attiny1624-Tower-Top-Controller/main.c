@@ -7,11 +7,11 @@
 #include "Settings.h"
 
 /**
- * @brief Main function to initialize peripherals and read MT6701 sensor data.
+ * @brief Main function to initialize peripherals and start the scheduler.
  * 
- * This function initializes the system clock, GPIO, and USART0 communication.
- * It then enters an infinite loop where it continuously reads the MT6701 sensor
- * data every 100 milliseconds.
+ * This function initializes the system clock, GPIO, USART0/USART1 and ADC0, then
+ * hands over to the scheduler, which runs the sampling and telemetry tasks at fixed
+ * periods (see SchedulerVar.h) and sleeps in between.
  *
  * @return int (not used, since the function never exits).
  */
@@ -21,36 +21,15 @@ int main(void)
 	CLOCK_XOSCHF_clock_init(); ///< Initialize exteral system clock
     //CLOCK_INHF_clock_init(); 
     GPIO_init(); ///< Initialize GPIO pins
+	YEndSwitches_init(); ///< Y end switch pin change interrupts
     USART0_init(); ///< Initialize USART0 for SPI communication
 	USART1_init();
+	Calibration_init(); ///< Per-unit calibration, before the first conversion
 	ADC0_init();
+	Energy_init(); ///< Restore the energy counter from EEPROM
+	sei(); ///< Enable interrupts (USART1 transmission, ADC and scheduler tick are interrupt driven)
+	Calibration_AutoZero(); ///< Optional current sensor zero measurement, needs the ADC interrupt
+	Scheduler_init(); ///< Start the 1 ms scheduler tick (after auto-zero, so no task falls behind)
 
-    while (1) 
-    {
-		//Test for extenal- internal clock
-		//PORTA.OUTTGL = PIN1_bm;
-        MT6701_SSI_Angle(Elevation_Angle); ///< Read MT6701 sensor data
-        MT6701_SSI_Angle(Azimuth_Angle); ///< Read MT6701 sensor data
-		//ReadSolarCells(Voltage); //uncomment if filtration no needded
-		//ReadSolarCells(Current); //uncomment if filtration no needded
-		FIR(Voltage); //comment if using ReadSolarCells(Voltage);
-		FIR(Current); //comment if using ReadSolarCells(Current);
-		uint8_t y = YEndSwitches();
-
-		Swap_Angle_Direction(Azimuth_Angle); // Change angle direction
-		Swap_Angle_Direction(Elevation_Angle); // change angle direction
-
-		uint8_t crc8 = crc8_cdma2000(((uint64_t)MT6701ELEVATION.Angle << 44) | ((uint64_t)MT6701AZIMUTH.Angle << 28) | ((uint64_t)ReadVoltage.Result << 16) | ((uint32_t)ReadCurrent.Result << 4) | y);
-
-		        // Send the combined data over USART0 in a formatted string
-		        USART1_printf("<%04x%04x%03x%03x%x%02x>\r\n",
-		        (uint16_t)MT6701ELEVATION.Angle,           ///< Elevation angle (4 digits) with changed direction
-		        (uint16_t)MT6701AZIMUTH.Angle,           ///< Azimuth angle (4 digits)
-		        (uint16_t)ReadVoltage.Result,           ///< Voltage (3 digits)
-		        (uint16_t)ReadCurrent.Result,            ///< Current (3 digits)
-		        (uint8_t)y,            ///< End switch status (1 digit)
-		        (uint8_t)crc8); ///< CRC value (2 digits)
-        _delay_ms(100); ///< Wait 100ms before the next write
-
-    }
-}
\ No newline at end of file
+	Scheduler_Run(); ///< Run sampling and telemetry tasks, never returns
+}
@@ -0,0 +1,355 @@
+/**
+ * @file TestAdc.c
+ * @brief Background ADC acquisition: trigger timing, conversion sequence and scaling.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+#define BURSTS 512 ///< Bursts recorded
+
+typedef struct {
+	uint8_t Mux;
+	uint8_t Shift;
+	uint64_t Start;
+	uint64_t End;
+	uint16_t Voltage; ///< Latest voltage sample when the burst ended (from an earlier burst)
+} BURST;
+
+static BURST bursts[BURSTS];
+static unsigned burst_count;
+
+static void RecordBurst(uint8_t muxpos, uint8_t shift, uint64_t start, uint64_t end) {
+	if (burst_count < BURSTS) {
+		bursts[burst_count++] = (BURST){ .Mux = muxpos & ADC_MUXPOS_gm, .Shift = shift, .Start = start, .End = end,
+			.Voltage = ADCAcquisition.Sample[ADC_SEQ_VOLTAGE] };
+	}
+}
+
+/**
+ * @brief Wraps a task in the table, recording the cycles it ran.
+ */
+#define INTERVALS 512
+
+static void (*angles_task)(void);
+static void (*solar_task)(void);
+static uint64_t angles_start[INTERVALS];
+static uint64_t angles_end[INTERVALS];
+static unsigned angles_count;
+static uint64_t solar_longest;
+
+static void TimedAngles(void) {
+	uint64_t start = HostCycles;
+
+	angles_task();
+	if (angles_count < INTERVALS) {
+		angles_start[angles_count] = start;
+		angles_end[angles_count++] = HostCycles;
+	}
+}
+
+static void TimedSolar(void) {
+	uint64_t start = HostCycles;
+
+	solar_task();
+	if (HostCycles - start > solar_longest) {
+		solar_longest = HostCycles - start;
+	}
+}
+
+static void Setup(void) {
+	HostElevation.Code = 4096;
+	HostAzimuth.Code = 12288;
+	HostAnalog.SolarVoltage = 150.0;
+	HostAnalog.SolarCurrent = 2.0;
+	HostAnalog.OnBurst = RecordBurst;
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_Angles) {
+			angles_task = Tasks[i].Run;
+			Tasks[i].Run = TimedAngles;
+		}
+		else if (Tasks[i].Run == Task_SolarCells) {
+			solar_task = Tasks[i].Run;
+			Tasks[i].Run = TimedSolar;
+		}
+	}
+}
+
+/**
+ * @brief Bursts start on every TCA0 overflow and follow the VDD, voltage/current, ... sequence.
+ */
+static void TestSequence(void) {
+	unsigned pairs = 0;
+
+	Setup();
+	Host_Run(2500000);
+	UNIT_CHECK(burst_count > 200);
+	UNIT_EQUAL(bursts[0].Mux, ADC_MUXPOS_VDDDIV10_gc); // VDD first, for the current scaling
+	for (unsigned i = 1; i < burst_count && !UnitFailures; i++) {
+		UNIT_EQUAL(bursts[i].Start - bursts[i - 1].Start, HOST_US(ADC_TRIGGER_PERIOD_MS * 1000UL));
+		UNIT_CHECK(bursts[i - 1].End < bursts[i].Start);
+		if (bursts[i].Mux == Current) {
+			UNIT_EQUAL(bursts[i - 1].Mux, Voltage);
+			pairs++;
+		}
+		else if (bursts[i].Mux == ADC_MUXPOS_VDDDIV10_gc) {
+			UNIT_EQUAL(bursts[i - 1].Mux, Current);
+			UNIT_EQUAL(pairs % VDD_MEASURE_ROUNDS, 0);
+		}
+		else {
+			UNIT_EQUAL(bursts[i].Mux, Voltage);
+		}
+	}
+	UNIT_EQUAL(ADC0.INTFLAGS & ADC_TRIGOVR_bm, 0);
+	UNIT_NEAR(ADC0_Latest(ADC_SEQ_VOLTAGE), 150.0 * 2 / 300 / 2.048 * 4096, 1);
+	UNIT_NEAR(ADC0_Latest(ADC_SEQ_CURRENT), (0.048 + 0.4 * 2.0) / 3.3 * 4096, 1);
+	UNIT_NEAR(ADC0_Latest(ADC_SEQ_VDD), 0.33 / 1.024 * 4096, 1);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief The measurement task never waits for the ADC, and conversions run during SSI reads.
+ */
+static void TestBackground(void) {
+	unsigned overlapping = 0;
+
+	Setup();
+	Host_Run(2500000);
+	printf("    longest SolarCells task: %llu cycles, longest burst %llu cycles\n",
+		(unsigned long long)solar_longest, (unsigned long long)(HOST_US(ADC_DEEP_US)));
+	UNIT_CHECK(solar_longest < HOST_US(20));
+	for (unsigned i = 0; i < burst_count; i++) {
+		for (unsigned j = 0; j < angles_count; j++) {
+			if (angles_start[j] < bursts[i].End && angles_end[j] > bursts[i].Start) {
+				overlapping++;
+				break;
+			}
+		}
+	}
+	printf("    bursts overlapping an SSI read: %u of %u\n", overlapping, burst_count);
+	UNIT_CHECK(overlapping > burst_count / 2);
+}
+
+/**
+ * @brief Former float conversion (before the integer multiply-shift).
+ */
+static uint16_t FloatCurrent(uint16_t sample, uint16_t vdd) {
+	float mcuVoltage = 0.25 * vdd;
+	float koef = mcuVoltage / 409.6;
+	return abs((int)((sample * koef / 4) - 12)); // abs() took the float converted to int
+}
+
+static uint16_t FloatVoltage(uint16_t sample) {
+	return 0.75 * sample;
+}
+
+/**
+ * @brief Integer scaling over every 12-bit sample and VDD pair against the float path.
+ *
+ * Where the two differ the integer result must be the exact one: with the default
+ * constants the current is sample * vdd * 5 / 32768 exactly, truncated towards zero
+ * after subtracting the zero offset like the float path did.
+ */
+static void TestFixedPoint(void) {
+	uint32_t differences = 0;
+	uint32_t worst = 0;
+
+	for (uint32_t vdd = 0; vdd < ADC_FULL_SCALE; vdd++) {
+		VddTracker.CurrentCoef = (vdd * Calibration.CurrentMul) >> TMCS1100_VDD_SHIFT; // As ADC0_TrackVdd()
+		for (uint32_t sample = 0; sample < ADC_FULL_SCALE; sample++) {
+			uint16_t fixed = ADC0_ScaleCurrent(sample);
+			uint16_t single = FloatCurrent(sample, vdd);
+
+			if (fixed != single) {
+				int64_t exact = (int64_t)sample * vdd * 5 - (int64_t)TMCS1100_ZERO_I * 32768; // 32768 * (I - zero)
+				uint32_t expected = llabs(exact) / 32768;                                      // Truncated towards zero
+
+				differences++;
+				if ((uint32_t)abs(fixed - single) > worst) {
+					worst = abs(fixed - single);
+				}
+				UNIT_EQUAL(fixed, expected);
+			}
+		}
+		if (UnitFailures) {
+			return;
+		}
+	}
+	printf("    current: %u of %lu inputs differ from float (max %u LSB), all exact\n",
+		differences, ADC_FULL_SCALE * ADC_FULL_SCALE, worst);
+	UNIT_CHECK(worst <= 1);
+
+	for (uint32_t sample = 0; sample < ADC_FULL_SCALE; sample++) {
+		UNIT_EQUAL(ADC0_ScaleVoltage(sample), FloatVoltage(sample));
+		if (UnitFailures) {
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Supply drifting from 3.3 V to 3.0 V between 2 s and 32 s.
+ */
+static double DriftingVdd(double seconds) {
+	if (seconds < 2.0) {
+		return 3.3;
+	}
+	if (seconds > 32.0) {
+		return 3.0;
+	}
+	return 3.3 - 0.3 * (seconds - 2.0) / 30.0;
+}
+
+/**
+ * @brief Reported current follows the tracked VDD while the supply drifts.
+ *
+ * The current sensor output is read against VDD, so without tracking the reading would
+ * grow by 3.3 / 3.0 (10%, 20 units at 2 A) over the drift.
+ */
+static void TestDriftingVdd(void) {
+	uint8_t text[64];
+	size_t position = 0;
+	size_t length;
+	uint64_t start;
+	double worst = 0;
+	double untracked = 0;
+	unsigned frames = 0;
+	TelemetryFrame frame;
+
+	Setup();
+	HostAnalog.VddAt = DriftingVdd;
+	Host_Run(40000000);
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) != 0) {
+		double t = (double)start / HOST_F_CPU;
+
+		UNIT_CHECK(Decode_Ascii(text, length, &frame));
+		if (t > 3.0) { // Filters settled
+			double error = fabs(frame.Current - 200.0);
+			double stale = 200.0 * (3.3 / DriftingVdd(t) - 1.0);
+
+			if (error > worst) {
+				worst = error;
+			}
+			if (stale > untracked) {
+				untracked = stale;
+			}
+		}
+		if (t > 38.0) {
+			UNIT_NEAR(frame.Current, 200, 2);
+		}
+		frames++;
+	}
+	printf("    worst current error %.0f units during the drift, %.0f without VDD tracking\n", worst, untracked);
+	UNIT_NEAR(frames, 400, 1);
+	UNIT_CHECK(worst <= 4);
+	UNIT_CHECK(ADC0_VddAge() <= (2 * VDD_MEASURE_ROUNDS + 1) * ADC_TRIGGER_PERIOD_MS);
+	UNIT_NEAR(VddTracker.Sample, 0.3 / 1.024 * 4096, 2);
+}
+
+/**
+ * @brief Voltage step from 150 V to 250 V at 2.05 s.
+ */
+static double SteppedVoltage(double seconds) {
+	return seconds < 2.05 ? 150.0 : 250.0;
+}
+
+/**
+ * @brief Result of burst i, read when the next burst ended.
+ */
+static uint16_t BurstResult(unsigned i) {
+	return bursts[i + 1].Voltage;
+}
+
+static double Deviation(const double *values, unsigned count) {
+	double mean = 0;
+	double sum = 0;
+
+	for (unsigned i = 0; i < count; i++) mean += values[i] / count;
+	for (unsigned i = 0; i < count; i++) sum += (values[i] - mean) * (values[i] - mean);
+	return count > 1 ? sqrt(sum / (count - 1)) : 0;
+}
+
+/**
+ * @brief A moving voltage switches to the fast profile at once and back after ADC_STEADY_ROUNDS.
+ *
+ * Burst times follow the profile table in ADC.h; the noise of each profile is reported
+ * from the results of its bursts with 2 LSB of conversion noise.
+ */
+static void TestProfiles(void) {
+	const double expected = 250.0 * 2 / 300 / 2.048 * 4096;
+	double deep[BURSTS];
+	double fast[BURSTS];
+	unsigned deepCount = 0;
+	unsigned fastCount = 0;
+	unsigned stepBurst = 0;
+	unsigned fastAfterStep = 0;
+	double settled = 0;
+
+	Setup();
+	HostAnalog.NoiseLsb = 2.0;
+	HostAnalog.SolarVoltageAt = SteppedVoltage;
+	Host_Run(4000000);
+	for (unsigned i = 0; i + 1 < burst_count && !UnitFailures; i++) {
+		const BURST *burst = &bursts[i];
+		double t = (double)burst->Start / HOST_F_CPU;
+		uint64_t length = burst->End - burst->Start;
+
+		switch (burst->Shift) {
+			case ADC_FAST_SHIFT: UNIT_NEAR(length, HOST_US(ADC_FAST_US), HOST_US(ADC_FAST_US) / 100); break;
+			case ADC_DEEP_SHIFT: UNIT_NEAR(length, HOST_US(ADC_DEEP_US), HOST_US(ADC_DEEP_US) / 100); break;
+			default:
+				UNIT_EQUAL(burst->Mux, ADC_MUXPOS_VDDDIV10_gc);
+				UNIT_EQUAL(burst->Shift, ADC_VDD_SHIFT);
+				UNIT_NEAR(length, HOST_US(ADC_VDD_US), HOST_US(ADC_VDD_US) / 100);
+				break;
+		}
+		if (burst->Mux == Current && t > 1.0) {
+			UNIT_EQUAL(burst->Shift, ADC_DEEP_SHIFT); // Steady channel not affected
+		}
+		if (burst->Mux != Voltage) {
+			continue;
+		}
+		if (t > 1.0 && t < 2.05) {
+			UNIT_EQUAL(burst->Shift, ADC_DEEP_SHIFT);
+			deep[deepCount++] = BurstResult(i);
+		}
+		else if (t >= 2.05 && !stepBurst) {
+			stepBurst = i; // First burst of the new level
+		}
+		else if (stepBurst && burst->Shift == ADC_FAST_SHIFT) {
+			fast[fastCount++] = BurstResult(i);
+			fastAfterStep++;
+		}
+		else if (stepBurst && !settled && fastAfterStep) {
+			settled = t;
+		}
+	}
+	printf("    deep: %u samples, %lu us, noise %.2f LSB; fast: %u samples, %lu us, noise %.2f LSB\n",
+		1 << ADC_DEEP_SHIFT, ADC_DEEP_US, Deviation(deep, deepCount),
+		1 << ADC_FAST_SHIFT, ADC_FAST_US, Deviation(fast, fastCount));
+	printf("    step at 2.05 s: %u fast bursts, deep again at %.2f s\n", fastAfterStep, settled);
+	UNIT_CHECK(stepBurst > 0);
+	for (unsigned i = stepBurst + 1; i < burst_count; i++) {
+		if (bursts[i].Mux == Voltage) {
+			UNIT_EQUAL(bursts[i].Shift, ADC_FAST_SHIFT); // Next voltage burst after the change was seen
+			break;
+		}
+	}
+	UNIT_NEAR(fastAfterStep, ADC_STEADY_ROUNDS, 1);
+	UNIT_CHECK(settled > 0);
+	UNIT_CHECK(Deviation(fast, fastCount) > Deviation(deep, deepCount));
+	UNIT_NEAR(ADC0_Latest(ADC_SEQ_VOLTAGE), expected, 1);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+int main(void) {
+	Unit_Case("bursts follow the trigger and the step sequence", TestSequence);
+	Unit_Case("conversions run in the background", TestBackground);
+	Unit_Case("fixed-point scaling matches the float conversion", TestFixedPoint);
+	Unit_Case("current scaling follows a drifting supply", TestDriftingVdd);
+	Unit_Case("acquisition profiles follow the signal activity", TestProfiles);
+	return Unit_Finish();
+}
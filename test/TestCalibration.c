@@ -0,0 +1,158 @@
+/**
+ * @file TestCalibration.c
+ * @brief Calibration records from the MakeCalibration builder loaded by the firmware.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include <string.h>
+#include "Settings.h"
+#include "CalibrationRecord.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+/**
+ * @brief Programs a record into the USERROW model before the firmware starts.
+ */
+static void Program(const uint8_t *record) {
+	memcpy((void *)&HostUSERROW.USERROW0[CALIBRATION_USERROW_OFFSET], record, sizeof(CALIBRATION_RECORD));
+}
+
+/**
+ * @brief A record of the default values gives the default coefficients.
+ */
+static void TestDefaults(void) {
+	const CALIBRATION defaults = Calibration;
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+
+	CalibrationRecord_Defaults(&values);
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) == NULL);
+	Program(record);
+	Host_Run(10000);
+	UNIT_EQUAL(Calibration.Source, CALIBRATION_USERROW);
+	UNIT_EQUAL(Calibration.VoltageMul, defaults.VoltageMul);
+	UNIT_EQUAL(Calibration.VoltageOffset, defaults.VoltageOffset);
+	UNIT_EQUAL(Calibration.CurrentMul, defaults.CurrentMul);
+	UNIT_EQUAL(Calibration.CurrentZero, defaults.CurrentZero);
+	UNIT_EQUAL(Calibration.AngleZero[0], 0);
+	UNIT_EQUAL(Calibration.AngleZero[1], 0);
+	UNIT_EQUAL(Calibration.Flags, defaults.Flags);
+}
+
+/**
+ * @brief Measured corrections reach the coefficients and the conversions.
+ */
+static void TestMeasured(void) {
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+
+	CalibrationRecord_Defaults(&values);
+	values.VoltageGain = 1.0123;
+	values.VoltageOffset = -0.3;
+	values.CurrentGain = 0.98;
+	values.CurrentZero = 0.14;
+	values.ElevationZero = 12.5;
+	values.AzimuthZero = -90.0;
+	values.Flags = CALIBRATION_AZIMUTH_REVERSED;
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) == NULL);
+	UNIT_EQUAL(record[0], CALIBRATION_VERSION);
+	UNIT_EQUAL(record[sizeof(record) - 1], Decode_Crc8(record, sizeof(record) - 1));
+	Program(record);
+	HostAnalog.SolarVoltage = 200.0;
+	HostAnalog.SolarCurrent = 3.0;
+	Host_Run(10000000); // Filters settled
+	UNIT_EQUAL(Calibration.Source, CALIBRATION_USERROW);
+	UNIT_EQUAL(Calibration.VoltageMul, (uint32_t)((uint64_t)AMC1311_COEF_MUL * 33171 >> CALIBRATION_GAIN_SHIFT)); // 1.0123 in Q1.15
+	UNIT_EQUAL(Calibration.VoltageOffset, -3);
+	UNIT_EQUAL(Calibration.CurrentMul, (uint32_t)((uint64_t)TMCS1100_COEF_MUL * 32113 >> CALIBRATION_GAIN_SHIFT)); // 0.98 in Q1.15
+	UNIT_EQUAL(Calibration.CurrentZero, 14);
+	UNIT_EQUAL(Calibration.AngleZero[0], 1250);
+	UNIT_EQUAL(Calibration.AngleZero[1], 27000);
+	UNIT_EQUAL(Calibration.Flags, CALIBRATION_AZIMUTH_REVERSED);
+	printf("    200 V, 3 A read as %.1f V, %.2f A\n", ReadVoltage.Result / 10.0, ReadCurrent.Result / 100.0);
+	UNIT_NEAR(ReadVoltage.Result, 2000 * 1.0123 - 3, 2);
+	UNIT_NEAR(ReadCurrent.Result, (300 + TMCS1100_ZERO_I) * 0.98 - 14, 2); // Model sensor has the default zero
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief Q1.15 gains end at 1.99997; 2.0 and negative gains are rejected.
+ */
+static void TestGainRange(void) {
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+
+	CalibrationRecord_Defaults(&values);
+	values.VoltageGain = 1.99997;
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) == NULL);
+	UNIT_EQUAL(record[1] | record[2] << 8, 0xFFFF);
+	values.VoltageGain = 0.0;
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) == NULL);
+	values.VoltageGain = 2.0;
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) != NULL);
+	values.VoltageGain = 1.0;
+	values.CurrentGain = -0.5;
+	UNIT_CHECK(CalibrationRecord_Build(&values, record) != NULL);
+}
+
+/**
+ * @brief The Intel HEX image carries the record at the address with valid checksums.
+ */
+static void TestHex(void) {
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+	char text[128];
+	unsigned count;
+	unsigned address;
+	unsigned type;
+	uint8_t sum;
+
+	CalibrationRecord_Defaults(&values);
+	values.CurrentZero = 0.14;
+	CalibrationRecord_Build(&values, record);
+	UNIT_EQUAL(CalibrationRecord_Hex(record, 0x0010, text, sizeof(text)), 1 + 2 * (4 + 15 + 1) + 1 + 12);
+	UNIT_EQUAL(sscanf(text, ":%2x%4x%2x", &count, &address, &type), 3);
+	UNIT_EQUAL(count, sizeof(record));
+	UNIT_EQUAL(address, 0x0010);
+	UNIT_EQUAL(type, 0);
+	sum = 0;
+	for (unsigned i = 0; i < 4 + count + 1; i++) {
+		unsigned byte;
+
+		sscanf(text + 1 + 2 * i, "%2x", &byte);
+		if (i >= 4 && i < 4 + count) {
+			UNIT_EQUAL(byte, record[i - 4]);
+		}
+		sum += byte;
+	}
+	UNIT_EQUAL(sum, 0);
+	UNIT_CHECK(strstr(text, "\n:00000001FF\n") != NULL);
+}
+
+/**
+ * @brief A record with a flipped bit keeps the defaults.
+ */
+static void TestInvalid(void) {
+	const CALIBRATION defaults = Calibration;
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+
+	CalibrationRecord_Defaults(&values);
+	values.CurrentZero = 0.2;
+	CalibrationRecord_Build(&values, record);
+	record[7] ^= 0x01; // Current zero
+	Program(record);
+	Host_Run(10000);
+	UNIT_EQUAL(Calibration.Source, CALIBRATION_DEFAULTS);
+	UNIT_EQUAL(Calibration.CurrentZero, defaults.CurrentZero);
+}
+
+int main(void) {
+	Unit_Case("record of the defaults", TestDefaults);
+	Unit_Case("measured corrections", TestMeasured);
+	Unit_Case("Q1.15 gain range", TestGainRange);
+	Unit_Case("Intel HEX image", TestHex);
+	Unit_Case("corrupted record keeps the defaults", TestInvalid);
+	return Unit_Finish();
+}
@@ -0,0 +1,192 @@
+/**
+ * @file TestChangeDriven.c
+ * @brief Change-driven telemetry (TELEMETRY_CHANGE_DRIVEN 1) replayed over a tracker trace.
+ *
+ * The trace is a minute of a tracker as the sensor models see it: both axes standing
+ * with one code of sensor jitter, one short move per axis, a cloud that pulls voltage
+ * and current down and an end switch that closes for two seconds. The receiver holds
+ * the last frame it got; at every telemetry period it must be within the deadbands of
+ * the values the firmware would have sent.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+#define TRACE_S 60
+#define PERIODS (TRACE_S * 1000 / TASK_TELEMETRY_PERIOD_MS)
+
+/**
+ * @brief Field values and start time of one telemetry period.
+ */
+typedef struct {
+	TelemetryFrame Frame; ///< Values the firmware had for the period
+	uint64_t Time;        ///< Task start, cycles
+} PERIOD;
+
+static void (*telemetry_task)(void);
+static PERIOD periods[PERIODS + 1];
+static unsigned period_count;
+
+static void RecordedTelemetry(void) {
+	uint64_t start = HostCycles;
+
+	telemetry_task();
+	if (period_count < PERIODS + 1) {
+		PERIOD *period = &periods[period_count++];
+		period->Time = start;
+		period->Frame.Elevation = MT6701ELEVATION.Average; // As averaged by the task
+		period->Frame.Azimuth = MT6701AZIMUTH.Average;
+		period->Frame.Voltage = ReadVoltage.Result;
+		period->Frame.Current = ReadCurrent.Result;
+		period->Frame.EndSwitches = YSwitch.State;
+		period->Frame.Status = (MT6701ELEVATION.Status << 4) | (MT6701AZIMUTH.Status & 0x0F);
+	}
+}
+
+/**
+ * @brief One code of jitter, different for every read.
+ */
+static int Jitter(double seconds, uint32_t seed) {
+	uint32_t x = (uint32_t)(seconds * 1e4) * 2654435761UL ^ seed;
+
+	x ^= x >> 15;
+	x *= 0x2C1B3C6DUL;
+	x ^= x >> 12;
+	return (int)(x % 3) - 1;
+}
+
+/**
+ * @brief Linear move from 0 to 1 between two times.
+ */
+static double Move(double seconds, double from, double to) {
+	return seconds <= from ? 0 : seconds >= to ? 1 : (seconds - from) / (to - from);
+}
+
+static uint16_t ElevationCode(double seconds) {
+	return 4000 + (int)(300 * Move(seconds, 20, 25)) + Jitter(seconds, 0x1234);
+}
+
+static uint16_t AzimuthCode(double seconds) {
+	return 9000 + (int)(-500 * Move(seconds, 30, 33)) + Jitter(seconds, 0x5678);
+}
+
+static double Cloud(double seconds) {
+	return 1 - 0.4 * (Move(seconds, 40, 41) - Move(seconds, 43, 44));
+}
+
+static double VoltageTrace(double seconds) {
+	return 200 * Cloud(seconds);
+}
+
+static double CurrentTrace(double seconds) {
+	return 2.0 * Cloud(seconds);
+}
+
+static void SwitchClose(void) {
+	Host_SetPinA(4, 0); // Y MAX closed
+}
+
+static void SwitchOpen(void) {
+	Host_SetPinA(4, 1);
+}
+
+/**
+ * @brief Period a frame belongs to, from its start time.
+ */
+static unsigned PeriodOf(uint64_t start) {
+	unsigned i = 0;
+
+	while (i + 1 < period_count && periods[i + 1].Time <= start) {
+		i++;
+	}
+	return i;
+}
+
+/**
+ * @brief Frames and bytes saved over the trace, and what the receiver holds meanwhile.
+ */
+static void TestReplay(void) {
+	static uint8_t sent[PERIODS + 1];
+	static TelemetryFrame received[PERIODS + 1];
+	uint8_t encoded[64];
+	uint8_t payload[64];
+	size_t position = 0;
+	uint64_t start;
+	size_t length;
+	unsigned frames = 0;
+	unsigned longest = 0;
+	unsigned silence = 0;
+	uint8_t sequence;
+	uint8_t expectedSequence = 0;
+	TelemetryFrame held;
+
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_Telemetry) {
+			telemetry_task = Tasks[i].Run;
+			Tasks[i].Run = RecordedTelemetry;
+		}
+	}
+	HostElevation.CodeAt = ElevationCode;
+	HostAzimuth.CodeAt = AzimuthCode;
+	HostAnalog.SolarVoltageAt = VoltageTrace;
+	HostAnalog.SolarCurrentAt = CurrentTrace;
+	HostAnalog.NoiseLsb = 1.0;
+	Host_At(HOST_US(50000000), SwitchClose);
+	Host_At(HOST_US(52000000), SwitchOpen);
+	Host_Run(TRACE_S * 1000000UL);
+	UNIT_EQUAL(period_count, PERIODS);
+
+	while ((length = Host_Uart1Frame(&position, 0x00, encoded, sizeof(encoded), &start)) != 0) {
+		TelemetryFrame frame;
+		unsigned period = PeriodOf(start);
+
+		if (Decode_Cobs(encoded, length, payload) != TELEMETRY_BINARY_PAYLOAD) {
+			continue; // End switch event frame
+		}
+		UNIT_EQUAL(Decode_Binary(payload, TELEMETRY_BINARY_PAYLOAD, &frame, &sequence), 1);
+		UNIT_EQUAL(sequence, expectedSequence++); // No gap: suppressed, not lost
+		UNIT_EQUAL(sent[period], 0);
+		sent[period] = 1;
+		received[period] = frame;
+		frames++;
+	}
+
+	UNIT_EQUAL(sent[0], 1);
+	for (unsigned i = 0; i < period_count && !UnitFailures; i++) {
+		const TelemetryFrame *truth = &periods[i].Frame;
+
+		if (sent[i]) {
+			held = received[i];
+			UNIT_EQUAL(held.Elevation, truth->Elevation);
+			UNIT_EQUAL(held.Voltage, truth->Voltage);
+			silence = 0;
+		}
+		else if (++silence > longest) {
+			longest = silence;
+		}
+		UNIT_CHECK(abs(held.Elevation - truth->Elevation) < TELEMETRY_DEADBAND_ANGLE);
+		UNIT_CHECK(abs(held.Azimuth - truth->Azimuth) < TELEMETRY_DEADBAND_ANGLE);
+		UNIT_CHECK(abs(held.Voltage - truth->Voltage) < TELEMETRY_DEADBAND_VOLTAGE);
+		UNIT_CHECK(abs(held.Current - truth->Current) < TELEMETRY_DEADBAND_CURRENT);
+		UNIT_EQUAL(held.EndSwitches, truth->EndSwitches);
+		UNIT_EQUAL(held.Status, truth->Status);
+	}
+
+	printf("    deadbands %u/%u/%u: %u of %u frames, %u of %u bytes (%.0f%% saved), longest silence %u periods\n",
+		TELEMETRY_DEADBAND_ANGLE, TELEMETRY_DEADBAND_VOLTAGE, TELEMETRY_DEADBAND_CURRENT,
+		frames, period_count, frames * TELEMETRY_BINARY_FRAME, period_count * TELEMETRY_BINARY_FRAME,
+		100.0 * (period_count - frames) / period_count, longest);
+	UNIT_CHECK(longest < TELEMETRY_HEARTBEAT_MS / TASK_TELEMETRY_PERIOD_MS); // Heartbeat
+	UNIT_CHECK(frames >= TRACE_S * 1000 / TELEMETRY_HEARTBEAT_MS);
+	UNIT_CHECK(frames < period_count / 2);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+int main(void) {
+	Unit_Case("replayed trace: frames saved within the deadbands", TestReplay);
+	return Unit_Finish();
+}
@@ -0,0 +1,136 @@
+/**
+ * @file TestCrc.c
+ * @brief Streaming CRC-8/CDMA2000 against the standard and the former 64-bit function.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "Bench.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+extern const uint8_t crc8_table[256]; ///< CRC.c
+
+/**
+ * @brief Former crc8_cdma2000(): CRC over the packed 64-bit word without its leading zero bytes.
+ */
+static uint8_t LegacyCrc(uint64_t data) {
+	uint8_t crc = 0xFF;
+	size_t length = 0;
+	uint64_t temp = data;
+
+	while (temp) {
+		length++;
+		temp >>= 8;
+	}
+	while (length--) {
+		crc = crc8_table[crc ^ ((data >> (length * 8)) & 0xFF)];
+	}
+	return crc;
+}
+
+static uint8_t StreamCrc(const uint8_t *data, size_t length) {
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	while (length--) {
+		crc = crc8_cdma2000_update(crc, *data++);
+	}
+	return crc8_cdma2000_final(crc);
+}
+
+static uint32_t random_state = 0x85EBCA6B;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Catalogue check value of CRC-8/CDMA2000 and the bitwise definition.
+ */
+static void TestCheckValue(void) {
+	uint8_t data[64];
+
+	UNIT_EQUAL(StreamCrc((const uint8_t *)"123456789", 9), 0xDA);
+	UNIT_EQUAL(StreamCrc(NULL, 0), 0xFF);
+	for (unsigned i = 0; i < 100000 && !UnitFailures; i++) {
+		size_t length = Random() % sizeof(data);
+
+		for (size_t j = 0; j < length; j++) {
+			data[j] = Random();
+		}
+		UNIT_EQUAL(StreamCrc(data, length), Decode_Crc8(data, length)); // Table against poly 0x9B
+	}
+}
+
+/**
+ * @brief The streaming CRC equals the former one whenever the first packed byte is not zero.
+ *
+ * With a zero first byte (elevation below 0x1000) the former function covered fewer
+ * bytes; the streaming CRC always covers all eight.
+ */
+static void TestLegacy(void) {
+	unsigned shorter = 0;
+
+	for (unsigned i = 0; i < 200000 && !UnitFailures; i++) {
+		uint64_t word = ((uint64_t)Random() << 32 | Random()) >> (Random() % 16); // Some leading zero nibbles
+		uint8_t bytes[8];
+
+		for (uint8_t j = 0; j < 8; j++) {
+			bytes[j] = word >> (56 - 8 * j);
+		}
+		if (bytes[0]) {
+			UNIT_EQUAL(StreamCrc(bytes, 8), LegacyCrc(word));
+		}
+		else {
+			shorter++;
+		}
+	}
+	UNIT_CHECK(shorter > 0);
+}
+
+static uint64_t bench_words[256];
+
+static void BenchLegacy(uint32_t i) {
+	BenchSink += LegacyCrc(bench_words[i & 0xFF]);
+}
+
+static void BenchStream(uint32_t i) {
+	const uint64_t word = bench_words[i & 0xFF];
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	for (int8_t shift = 56; shift >= 0; shift -= 8) {
+		crc = crc8_cdma2000_update(crc, word >> shift); // Bytes as the serializer produces them
+	}
+	BenchSink += crc8_cdma2000_final(crc);
+}
+
+/**
+ * @brief Host CPU time of both over full 8-byte frames.
+ *
+ * The former function's 64-bit shifts are far more expensive on AVR than on the host,
+ * where both take a few nanoseconds, so the ratio is only reported, not checked.
+ */
+static void TestBenchmark(void) {
+	double legacy_ns;
+	double stream_ns;
+
+	for (unsigned i = 0; i < 256; i++) {
+		bench_words[i] = (uint64_t)(Random() | 0x10000000UL) << 32 | Random(); // First byte not zero
+	}
+	legacy_ns = Bench_Run(BenchLegacy, 1000000, 5);
+	stream_ns = Bench_Run(BenchStream, 1000000, 5);
+	printf("    64-bit: %.1f ns/frame, streaming: %.1f ns/frame, ratio %.1f\n",
+		legacy_ns, stream_ns, legacy_ns / stream_ns);
+	UNIT_CHECK(stream_ns > 0 && legacy_ns > 0);
+}
+
+int main(void) {
+	Unit_Case("check value 0xDA and the bitwise definition", TestCheckValue);
+	Unit_Case("same CRC as the former function over 8 packed bytes", TestLegacy);
+	Unit_Case("host CPU time of both functions", TestBenchmark);
+	return Unit_Finish();
+}
@@ -0,0 +1,237 @@
+/**
+ * @file TestDiagnostics.c
+ * @brief Diagnostic frame contents (DIAG_ENABLE 1) and its absence (DIAG_ENABLE 0).
+ *
+ * Built against both firmware variants; each runs the cases for its setting.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+/**
+ * @brief Byte offsets in the decoded diagnostic frame (see Diagnostics.c).
+ */
+#define DIAG_AT_STAGE(stage) (1 + (stage) * 6)
+#define DIAG_AT_OVERFLOW (1 + DIAG_STAGES * 6)
+#define DIAG_AT_AWAKE (DIAG_AT_OVERFLOW + 2)
+#define DIAG_AT_VDD_AGE (DIAG_AT_AWAKE + 2)
+#define DIAG_AT_ANGLE_AGE (DIAG_AT_VDD_AGE + 2)          ///< Elevation, azimuth
+#define DIAG_AT_ANGLE_ERRORS(sensor) (DIAG_AT_ANGLE_AGE + 2 + (sensor) * 4) ///< CommErrors, FieldErrors
+#define DIAG_AT_EVENTS (DIAG_AT_ANGLE_ERRORS(2))
+
+/**
+ * @brief One decoded diagnostic frame and its start time.
+ */
+typedef struct {
+	uint8_t Data[DIAG_PAYLOAD];
+	double Time;
+} DIAG_FRAME;
+
+#define FRAMES 64
+
+static size_t position;
+
+#if DIAG_ENABLE
+static DIAG_FRAME frames[FRAMES];
+static unsigned frame_count;
+
+static uint16_t Word(const DIAG_FRAME *frame, unsigned offset) {
+	return (frame->Data[offset] << 8) | frame->Data[offset + 1];
+}
+
+/**
+ * @brief Collects the diagnostic frames captured since the last call.
+ */
+static void Collect(void) {
+	uint8_t text[256];
+	size_t length;
+	uint64_t start;
+
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) != 0) {
+		if (text[0] != DIAG_ASCII_START || frame_count >= FRAMES) {
+			continue;
+		}
+		UNIT_EQUAL(Decode_AsciiRaw(text, length, DIAG_ASCII_START, frames[frame_count].Data), DIAG_PAYLOAD);
+		UNIT_EQUAL(frames[frame_count].Data[0], DIAG_FRAME_ID);
+		frames[frame_count++].Time = (double)start / HOST_F_CPU;
+	}
+}
+
+/**
+ * @brief A frame every TASK_DIAGNOSTICS_PERIOD_MS with consistent times for every stage.
+ */
+static void TestStageTimes(void) {
+	const double transfer_us = 3 * 8 * 1e6 / SSI_CLOCK_HZ;
+
+	Host_Run(5500000);
+	Collect();
+	UNIT_EQUAL(frame_count, 6);
+	for (unsigned i = 1; i < frame_count; i++) {
+		UNIT_NEAR(frames[i].Time - frames[i - 1].Time, TASK_DIAGNOSTICS_PERIOD_MS / 1000.0, 1e-3);
+	}
+	for (unsigned i = 1; i < frame_count; i++) { // The first window may be partly empty
+		for (uint8_t stage = 0; stage < DIAG_STAGES; stage++) {
+			uint16_t last = Word(&frames[i], DIAG_AT_STAGE(stage));
+			uint16_t min = Word(&frames[i], DIAG_AT_STAGE(stage) + 2);
+			uint16_t max = Word(&frames[i], DIAG_AT_STAGE(stage) + 4);
+
+			UNIT_CHECK(min <= last && last <= max);
+			UNIT_CHECK(max < 1000);
+		}
+	}
+	UNIT_NEAR(Word(&frames[frame_count - 1], DIAG_AT_STAGE(DIAG_SSI_ELEVATION)), transfer_us, 8);
+	UNIT_NEAR(Word(&frames[frame_count - 1], DIAG_AT_STAGE(DIAG_SSI_AZIMUTH)), transfer_us, 8);
+	UNIT_EQUAL(Word(&frames[frame_count - 1], DIAG_AT_OVERFLOW), 0);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief The frame reports the VDD measurement age, which grows once the ADC stops.
+ */
+static void TestVddAge(void) {
+	unsigned running;
+
+	Host_Run(5500000);
+	Collect();
+	running = frame_count;
+	UNIT_EQUAL(running, 6); // First frame at TASK_DIAGNOSTICS_OFFSET_MS
+	for (unsigned i = 0; i < running; i++) {
+		uint16_t age = Word(&frames[i], DIAG_AT_VDD_AGE);
+
+		UNIT_CHECK(age <= (2 * VDD_MEASURE_ROUNDS + 1) * ADC_TRIGGER_PERIOD_MS);
+	}
+
+	TCA0.SINGLE.CTRLA = 0; // No more ADC triggers
+	Host_Run(3000000);
+	Collect();
+	UNIT_EQUAL(frame_count, running + 3);
+	UNIT_CHECK(Word(&frames[frame_count - 1], DIAG_AT_VDD_AGE) > 2000);
+	UNIT_NEAR(Word(&frames[frame_count - 1], DIAG_AT_VDD_AGE) - Word(&frames[frame_count - 2], DIAG_AT_VDD_AGE),
+		TASK_DIAGNOSTICS_PERIOD_MS, 1);
+}
+
+/**
+ * @brief The frame reports the MT6701 angle ages and error counters.
+ */
+static void TestAngleErrors(void) {
+	const DIAG_FRAME *last;
+
+	HostAzimuth.CrcErrors = UINT16_MAX; // Every azimuth read fails
+	HostElevation.Field = 2;           // Every elevation read fails, magnetic field too weak
+	Host_Run(1100000);
+	Collect();
+	UNIT_EQUAL(frame_count, 2);
+	last = &frames[frame_count - 1];
+	UNIT_NEAR(last->Data[DIAG_AT_ANGLE_AGE], (TASK_DIAGNOSTICS_PERIOD_MS + TASK_DIAGNOSTICS_OFFSET_MS) / TASK_ANGLES_PERIOD_MS, 1);
+	UNIT_EQUAL(last->Data[DIAG_AT_ANGLE_AGE + 1], last->Data[DIAG_AT_ANGLE_AGE]);
+	UNIT_EQUAL(Word(last, DIAG_AT_ANGLE_ERRORS(0)), 0);
+	UNIT_EQUAL(Word(last, DIAG_AT_ANGLE_ERRORS(0) + 2), last->Data[DIAG_AT_ANGLE_AGE] * MT6701_READ_ATTEMPTS);
+	UNIT_EQUAL(Word(last, DIAG_AT_ANGLE_ERRORS(1)), last->Data[DIAG_AT_ANGLE_AGE + 1] * MT6701_READ_ATTEMPTS);
+	UNIT_EQUAL(Word(last, DIAG_AT_ANGLE_ERRORS(1) + 2), 0);
+
+	HostAzimuth.CrcErrors = 0;
+	HostElevation.Field = 0;
+	Host_Run(1000000);
+	Collect();
+	last = &frames[frame_count - 1];
+	UNIT_EQUAL(last->Data[DIAG_AT_ANGLE_AGE], 0);
+	UNIT_EQUAL(last->Data[DIAG_AT_ANGLE_AGE + 1], 0);
+}
+
+/**
+ * @brief The frame reports the end switch events since start-up.
+ */
+static void TestEvents(void) {
+	Host_Run(500000);
+	for (uint8_t i = 0; i < 3; i++) {
+		Host_SetPinA(5, i & 1); // Y MIN closed, open, closed
+		Host_Run(20000);
+	}
+	Host_Run(1000000);
+	Collect();
+	UNIT_EQUAL(Word(&frames[0], DIAG_AT_EVENTS), 0);
+	UNIT_EQUAL(Word(&frames[frame_count - 1], DIAG_AT_EVENTS), 3);
+}
+
+static void (*diagnostics_task)(void);
+static uint64_t diag_cycles[FRAMES];      ///< Time of every diagnostic task run
+static uint64_t diag_sleep_cycles[FRAMES]; ///< HostSleepCycles at that time
+static unsigned diag_runs;
+
+static void RecordedDiagnostics(void) {
+	if (diag_runs < FRAMES) {
+		diag_cycles[diag_runs] = HostCycles;
+		diag_sleep_cycles[diag_runs++] = HostSleepCycles;
+	}
+	diagnostics_task();
+}
+
+/**
+ * @brief The reported awake time matches the time the model CPU spent outside SLEEP.
+ *
+ * The SSI transfers sleep too (about 1% of the time with two sensors); they used to
+ * be counted as awake.
+ */
+static void TestAwakeTime(void) {
+	double worst = 0;
+
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_Diagnostics) {
+			diagnostics_task = Tasks[i].Run;
+			Tasks[i].Run = RecordedDiagnostics;
+		}
+	}
+	Host_Run(10500000);
+	Collect();
+	UNIT_EQUAL(frame_count, diag_runs);
+	for (unsigned i = 1; i < frame_count; i++) {
+		double window = diag_cycles[i] - diag_cycles[i - 1];
+		double awake = 1000.0 * (1.0 - (diag_sleep_cycles[i] - diag_sleep_cycles[i - 1]) / window);
+		double error = Word(&frames[i], DIAG_AT_AWAKE) - awake;
+
+		if (fabs(error) > fabs(worst)) {
+			worst = error;
+		}
+	}
+	printf("    awake %u per mille, model %+.2f per mille worst difference\n",
+		Word(&frames[frame_count - 1], DIAG_AT_AWAKE), worst);
+	UNIT_CHECK(fabs(worst) <= 2.0);
+}
+
+#else
+/**
+ * @brief Without DIAG_ENABLE there is no diagnostic task and no diagnostic frame.
+ */
+static void TestDisabled(void) {
+	size_t telemetry = 0;
+	uint8_t text[256];
+	uint64_t start;
+	size_t length;
+
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		UNIT_CHECK(Tasks[i].Period != TASK_DIAGNOSTICS_PERIOD_MS);
+	}
+	Host_Run(5500000);
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) != 0) {
+		UNIT_CHECK(text[0] == '<');
+		telemetry++;
+	}
+	UNIT_EQUAL(telemetry, 5500 / TASK_TELEMETRY_PERIOD_MS);
+}
+#endif
+
+int main(void) {
+#if DIAG_ENABLE
+	Unit_Case("a frame every second with the stage times", TestStageTimes);
+	Unit_Case("VDD measurement age", TestVddAge);
+	Unit_Case("MT6701 angle ages and error counters", TestAngleErrors);
+	Unit_Case("end switch events", TestEvents);
+	Unit_Case("awake time against the model CPU", TestAwakeTime);
+#else
+	Unit_Case("no diagnostic frame with DIAG_ENABLE 0", TestDisabled);
+#endif
+	return Unit_Finish();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file TestEndSwitches.c
+ * @brief End switch edges at random points of the cycle: event frames and their latency.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+#define EDGES 400
+
+static uint64_t edges[EDGES];  ///< Edge times, cycles
+static uint8_t levels[EDGES];  ///< Y MAX pin level after the edge
+static unsigned edge_count;
+static uint8_t level = 1;      ///< Open, pulled up
+
+static uint32_t random_state = 0x9E3779B9;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Toggles Y MAX and schedules the next edge 20 to 70 ms later, at any point of the cycle.
+ */
+static void Toggle(void) {
+	level = !level;
+	Host_SetPinA(4, level);
+	edges[edge_count] = HostCycles;
+	levels[edge_count++] = level;
+	if (edge_count < EDGES) {
+		Host_At(HostCycles + HOST_US(20000 + Random() % 50000), Toggle);
+	}
+}
+
+/**
+ * @brief Bounce: a burst of edges within the lockout, settling closed.
+ */
+static void Bounce(void) {
+	for (uint8_t i = 0; i < 7; i++) {
+		Host_SetPinA(4, i & 1); // Ends low (closed)
+		Host_Busy(300);
+	}
+}
+
+/**
+ * @brief Every edge is sent as an event frame within the rest of the block on the line.
+ */
+static void TestLatency(void) {
+	uint64_t byte;
+	uint64_t bound;
+	uint8_t text[64];
+	uint8_t event[TELEMETRY_EVENT_PAYLOAD];
+	size_t position = 0;
+	size_t length;
+	uint64_t start;
+	uint64_t worst = 0;
+	double sum = 0;
+	unsigned events = 0;
+	unsigned telemetry = 0;
+
+	Host_At(HOST_US(1000 * (TASK_TELEMETRY_OFFSET_MS + TASK_TELEMETRY_PERIOD_MS) + 150), Toggle); // First edge just after a telemetry frame started
+	Host_Run(EDGES * 70000 + 500000);
+	UNIT_EQUAL(edge_count, EDGES);
+	byte = Host_Uart1ByteCycles();
+	bound = (TELEMETRY_ASCII_FRAME + 1) * byte + HOST_US(30); // Rest of a telemetry frame, the byte in the transmitter, the interrupt
+
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) != 0) {
+		if (text[0] == '<') {
+			TelemetryFrame frame;
+			UNIT_CHECK(Decode_Ascii(text, length, &frame)); // Never cut by an event frame
+			telemetry++;
+			continue;
+		}
+		UNIT_EQUAL(Decode_AsciiRaw(text, length, TELEMETRY_EVENT_ASCII_START, event), TELEMETRY_EVENT_PAYLOAD);
+		if (events >= edge_count || UnitFailures) {
+			break;
+		}
+		UNIT_EQUAL(event[0], TELEMETRY_EVENT_ID);
+		UNIT_EQUAL(event[1], levels[events] ? 0 : 2); // Y MAX active low
+		UNIT_CHECK(start > edges[events]);
+		UNIT_EQUAL((event[2] << 8) | event[3], 0); // Queued in the interrupt, not retried
+		if (start - edges[events] > worst) {
+			worst = start - edges[events];
+		}
+		sum += start - edges[events];
+		events++;
+	}
+	printf("    %u edges: mean latency %.1f us, worst %.1f us (bound %.1f us, frame byte %.1f us)\n",
+		events, sum / events * 1e6 / HOST_F_CPU, worst * 1e6 / (double)HOST_F_CPU,
+		bound * 1e6 / (double)HOST_F_CPU, byte * 1e6 / (double)HOST_F_CPU);
+	UNIT_EQUAL(events, EDGES);
+	UNIT_EQUAL(YSwitch.Events, EDGES);
+	UNIT_CHECK(worst <= bound);
+	UNIT_CHECK(worst > (TELEMETRY_ASCII_FRAME - 3) * byte); // The first edge waited for most of a frame
+	UNIT_NEAR(telemetry, (EDGES * 70000 + 500000) / 1000 / TASK_TELEMETRY_PERIOD_MS, 1);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief Bounces within the lockout give one event for the first edge and one for the settled state.
+ */
+static void TestBounce(void) {
+	uint8_t text[64];
+	uint8_t event[TELEMETRY_EVENT_PAYLOAD];
+	size_t position = 0;
+	size_t length;
+	unsigned events = 0;
+	uint8_t states[4];
+
+	Host_Run(100000);
+	Bounce(); // First edge: closed, then 6 bounces in 2.1 ms, settles closed
+	Host_Run(20000);
+	Host_SetPinA(4, 1);
+	Host_Busy(300);
+	Host_SetPinA(4, 0); // Released and closed again within the lockout
+	Host_Run(20000);
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), NULL)) != 0) {
+		if (text[0] == TELEMETRY_EVENT_ASCII_START && events < 4) {
+			UNIT_EQUAL(Decode_AsciiRaw(text, length, TELEMETRY_EVENT_ASCII_START, event), TELEMETRY_EVENT_PAYLOAD);
+			states[events++] = event[1];
+		}
+	}
+	UNIT_EQUAL(events, 3);
+	UNIT_EQUAL(states[0], 2); // Closed at the first edge
+	UNIT_EQUAL(states[1], 0); // Released at the second burst
+	UNIT_EQUAL(states[2], 2); // Closed again once the lockout ended
+	UNIT_EQUAL(YSwitch.Events, 3);
+}
+
+int main(void) {
+	Unit_Case("event latency for edges at random points of the cycle", TestLatency);
+	Unit_Case("bounces within the lockout", TestBounce);
+	return Unit_Finish();
+}
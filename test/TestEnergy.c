@@ -0,0 +1,151 @@
+/**
+ * @file TestEnergy.c
+ * @brief Energy integration against an analytic reference and the EEPROM record writer.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "Unit.h"
+
+#define PI 3.14159265358979323846
+
+/**
+ * @brief Synthetic string: V = A + B sin(wv t), I = C + D sin(wi t).
+ */
+#define WAVE_A 200.0
+#define WAVE_B 60.0
+#define WAVE_C 2.0
+#define WAVE_D 1.2
+#define WAVE_WV (2 * PI / 13.0)
+#define WAVE_WI (2 * PI / 4.7)
+
+static double WaveVoltage(double seconds) {
+	return WAVE_A + WAVE_B * sin(WAVE_WV * seconds);
+}
+
+static double WaveCurrent(double seconds) {
+	return WAVE_C + WAVE_D * sin(WAVE_WI * seconds);
+}
+
+/**
+ * @brief Integral of V * I from 0 to t in Ws.
+ */
+static double WaveEnergy(double t) {
+	return WAVE_A * WAVE_C * t
+		+ WAVE_A * WAVE_D * (1 - cos(WAVE_WI * t)) / WAVE_WI
+		+ WAVE_B * WAVE_C * (1 - cos(WAVE_WV * t)) / WAVE_WV
+		+ WAVE_B * WAVE_D / 2 * (sin((WAVE_WV - WAVE_WI) * t) / (WAVE_WV - WAVE_WI)
+			- sin((WAVE_WV + WAVE_WI) * t) / (WAVE_WV + WAVE_WI));
+}
+
+/**
+ * @brief Counter with the remainder, in mWh.
+ */
+static double Counted(void) {
+	return EnergyMeter.Energy + (double)EnergyMeter.Remainder / ENERGY_MW_MS_PER_UNIT;
+}
+
+/**
+ * @brief Ten minutes of varying voltage and current against the analytic integral.
+ */
+static void TestAnalytic(void) {
+	const double from = 5.0;
+	const double to = 605.0;
+	double start;
+	double reference;
+	double counted;
+
+	HostAnalog.SolarVoltageAt = WaveVoltage;
+	HostAnalog.SolarCurrentAt = WaveCurrent;
+	HostAnalog.NoiseLsb = 1.0;
+	Host_Run(from * 1e6);
+	start = Counted();
+	Host_Run((to - from) * 1e6);
+	counted = Counted() - start;
+	reference = (WaveEnergy(to) - WaveEnergy(from)) / 3.6; // Ws to mWh
+	printf("    %.1f mWh counted, %.1f mWh reference, error %+.3f%%\n",
+		counted, reference, 100 * (counted - reference) / reference);
+	UNIT_NEAR(counted, reference, reference * 0.005); // Within the 0.1 V x 0.01 A resolution of the scaled samples
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief A capped gap at the highest calibrated power integrates without wrapping.
+ *
+ * With both gains at 1.99997 the mean power times ENERGY_MAX_DT_MS exceeds 32 bits.
+ */
+static void TestLargestPower(void) {
+	uint8_t pairs;
+	uint32_t power;
+	double start;
+	double counted;
+	double expected;
+
+	Calibration.VoltageMul = (uint64_t)AMC1311_COEF_MUL * 0xFFFF >> CALIBRATION_GAIN_SHIFT; // Before start-up, no USERROW record
+	Calibration.CurrentMul = (uint64_t)TMCS1100_COEF_MUL * 0xFFFF >> CALIBRATION_GAIN_SHIFT;
+	HostAnalog.SolarVoltage = 290.0;
+	HostAnalog.SolarCurrent = 11.0;
+	Host_Run(3000000);
+	power = EnergyMeter.Power;
+	UNIT_CHECK((uint64_t)power * ENERGY_MAX_DT_MS > UINT32_MAX);
+	start = Counted();
+	pairs = EnergyMeter.Pairs;
+	EnergyMeter.PairTime -= 5000; // As after a 5 s acquisition stall
+	while (EnergyMeter.Pairs == pairs) {
+		Host_Run(TASK_ENERGY_PERIOD_MS * 1000);
+	}
+	counted = Counted() - start;
+	expected = (double)power * ENERGY_MAX_DT_MS / ENERGY_MW_MS_PER_UNIT; // Gap counted as ENERGY_MAX_DT_MS
+	printf("    %.1f kW over a capped gap: %.1f mWh counted, %.1f mWh expected\n",
+		power / 1e6, counted, expected);
+	UNIT_NEAR(counted, expected, expected * 0.01);
+}
+
+/**
+ * @brief Restarts the meter from EEPROM as after a reset.
+ */
+static uint32_t Restored(void) {
+	EnergyMeter.Energy = 0;
+	EnergyMeter.Sequence = 0;
+	EnergyMeter.Slot = ENERGY_SLOTS - 1;
+	Energy_init();
+	return EnergyMeter.Energy;
+}
+
+/**
+ * @brief Saves are written byte by byte without waiting, and a torn record is ignored.
+ */
+static void TestSave(void) {
+	uint32_t saved[2];
+
+	HostAnalog.SolarVoltage = 250.0;
+	HostAnalog.SolarCurrent = 4.0;
+	for (uint8_t i = 0; i < 2; i++) {
+		Host_Run(2000000);
+		EnergyMeter.SaveCountdown = 1; // Save at the next run
+		Host_Run(TASK_ENERGY_PERIOD_MS * 1000);
+		saved[i] = EnergyMeter.Saved;
+		UNIT_EQUAL(EnergyMeter.Writing, sizeof(ENERGY_SLOT) - 1);
+		Host_Run(sizeof(ENERGY_SLOT) * TASK_ENERGY_PERIOD_MS * 1000);
+		UNIT_EQUAL(EnergyMeter.Writing, 0);
+	}
+	printf("    %u EEPROM bytes written, longest EEPROM wait %.1f us\n",
+		HostEepromWrites, HostEepromLongestWait * 1e6 / HOST_F_CPU);
+	UNIT_CHECK(saved[0] > 0 && saved[1] > saved[0]);
+	UNIT_CHECK(HostEepromLongestWait < HOST_US(10)); // Never waits for a write to finish
+
+	Host_Run(2000000);
+	EnergyMeter.SaveCountdown = 1;
+	Host_Run(4 * TASK_ENERGY_PERIOD_MS * 1000); // Reset after 3 of the bytes
+	UNIT_EQUAL(EnergyMeter.Writing, sizeof(ENERGY_SLOT) - 4);
+	UNIT_EQUAL(Restored(), saved[1]); // Torn record fails its CRC
+	UNIT_EQUAL(EnergyMeter.Slot, 1);
+}
+
+int main(void) {
+	Unit_Case("integrated energy against the analytic integral", TestAnalytic);
+	Unit_Case("highest calibrated power over a capped gap", TestLargestPower);
+	Unit_Case("EEPROM save without waiting, torn record ignored", TestSave);
+	return Unit_Finish();
+}
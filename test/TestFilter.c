@@ -0,0 +1,180 @@
+/**
+ * @file TestFilter.c
+ * @brief Filter pipeline stages against reference implementations.
+ *
+ * Filter.c is included so that the stages can be run with any constant parameters;
+ * the measurement it reads from is replaced by the channel state set by the test.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "../Attiny1624-Tower-Top-Controller/Filter.c"
+#include "Unit.h"
+
+ADC_VALUES ReadVoltage;
+ADC_VALUES ReadCurrent;
+
+void ReadSolarCells(solarrcells_t channel) {
+	(void)channel; // Result is set by the test
+}
+
+static uint32_t random_state = 0x1B873593;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Test input: random 12-bit values, full-scale steps and slow ramps in turn.
+ */
+static uint16_t Input(uint32_t n) {
+	switch ((n / 5000) % 3) {
+		case 0: return Random() & 0x0FFF;
+		case 1: return (n / 700) % 2 ? FIR_SAMPLE_MAX : 0;
+		default: return (n / 3) % (FIR_SAMPLE_MAX + 1);
+	}
+}
+
+/**
+ * @brief Former FIR(): store the sample, then average the whole buffer.
+ */
+typedef struct {
+	uint16_t Filter[255];
+	uint8_t index;
+} LEGACY_BOXCAR;
+
+static uint16_t LegacyBoxcar(LEGACY_BOXCAR *state, uint8_t steps, uint16_t sample) {
+	uint32_t sum = 0;
+
+	state->Filter[state->index] = sample;
+	state->index = (state->index + 1) % steps;
+	for (uint8_t i = 0; i < steps; i++) {
+		sum += state->Filter[i];
+	}
+	return sum / steps;
+}
+
+/**
+ * @brief Running-sum boxcar with a compile-time length against the former full-buffer average.
+ */
+#define CHECK_BOXCAR(steps) \
+	do { \
+		static uint16_t buffer[steps]; \
+		ADC_VALUES values = { .Filter = buffer }; \
+		LEGACY_BOXCAR legacy = { .index = 0 }; \
+		for (uint32_t n = 0; n < 300000; n++) { \
+			uint16_t sample = Input(n); \
+			if (Filter_Boxcar(&values, steps, sample) != LegacyBoxcar(&legacy, steps, sample)) { \
+				UNIT_EQUAL(Filter_Boxcar(&values, steps, sample), LegacyBoxcar(&legacy, steps, sample)); \
+				printf("    length %u differs at sample %u\n", steps, n); \
+				return; \
+			} \
+		} \
+	} while (0)
+
+static void TestBoxcarIdentical(void) {
+	CHECK_BOXCAR(1);
+	CHECK_BOXCAR(2);
+	CHECK_BOXCAR(3);
+	CHECK_BOXCAR(5);
+	CHECK_BOXCAR(7);
+	CHECK_BOXCAR(8);
+	CHECK_BOXCAR(12);
+	CHECK_BOXCAR(16);
+	CHECK_BOXCAR(20);
+	CHECK_BOXCAR(24);
+	CHECK_BOXCAR(31);
+	CHECK_BOXCAR(48);
+	CHECK_BOXCAR(64);
+	CHECK_BOXCAR(100);
+	CHECK_BOXCAR(128);
+	CHECK_BOXCAR(255);
+}
+
+/**
+ * @brief Former IIR stage, which settled 1 / 2^shift below a constant input.
+ */
+static uint16_t LegacyIir(ADC_VALUES *values, uint8_t shift, uint16_t sample) {
+	values->Sum += sample;
+	values->Sum -= values->Sum >> shift;
+	return values->Sum >> shift;
+}
+
+static uint16_t FirmwareIir(ADC_VALUES *values, uint8_t shift, uint16_t sample) {
+	return Filter_Iir(values, shift, sample);
+}
+
+/**
+ * @brief Deviation of an IIR stage from y += (x - y) / 2^shift in double.
+ */
+typedef struct {
+	double Tracking;   ///< Largest |output - reference| over steps and ramps, LSB
+	int32_t Settled;   ///< Output minus input after a long constant input, LSB
+	int32_t Impulse;   ///< Sum of the impulse response minus the impulse height
+} IIR_RESPONSE;
+
+static IIR_RESPONSE IirResponse(uint16_t (*iir)(ADC_VALUES *, uint8_t, uint16_t), uint8_t shift) {
+	ADC_VALUES values = { .Sum = 0 };
+	IIR_RESPONSE response = { 0, 0, 0 };
+	double reference = 0;
+	int32_t impulse = 0;
+
+	for (uint32_t n = 0; n < 24000; n++) {
+		uint16_t sample;
+		uint16_t output;
+
+		if (n < 4000) sample = 0;                                   // Settled at zero
+		else if (n < 8000) sample = FIR_SAMPLE_MAX;                 // Step up
+		else if (n < 12000) sample = 1000;                          // Step down
+		else if (n < 16000) sample = 1000 + (n - 12000) * 3 / 4;    // Ramp up, 0.75 LSB per sample
+		else if (n < 20000) sample = FIR_SAMPLE_MAX - (n - 16000);  // Ramp down, 1 LSB per sample
+		else sample = 0;
+		output = iir(&values, shift, sample);
+		reference += (sample - reference) / (1 << shift);
+		if (fabs(output - reference) > response.Tracking) {
+			response.Tracking = fabs(output - reference);
+		}
+		if (n == 7999) {
+			response.Settled = (int32_t)output - FIR_SAMPLE_MAX;
+		}
+	}
+
+	values.Sum = 0; // Impulse from rest
+	impulse = -(int32_t)FIR_SAMPLE_MAX;
+	for (uint32_t n = 0; n < 4000; n++) {
+		impulse += iir(&values, shift, n == 0 ? FIR_SAMPLE_MAX : 0);
+	}
+	response.Impulse = impulse;
+	return response;
+}
+
+/**
+ * @brief Step, ramp and impulse responses of the IIR stage for every strength.
+ *
+ * Unity DC gain: a constant input settles exactly, the impulse response sums to the
+ * impulse height (less what stays below one output LSB) and steps and ramps follow the
+ * exact low-pass within the truncation of the accumulator.
+ */
+static void TestIirResponse(void) {
+	for (uint8_t shift = 1; shift <= 8; shift++) {
+		IIR_RESPONSE fixed = IirResponse(FirmwareIir, shift);
+		IIR_RESPONSE legacy = IirResponse(LegacyIir, shift);
+
+		printf("    shift %u: tracking %.2f LSB, settled %+d, impulse sum %+d (former stage: %.0f, %+d, %+d)\n",
+			shift, fixed.Tracking, fixed.Settled, fixed.Impulse, legacy.Tracking, legacy.Settled, legacy.Impulse);
+		UNIT_EQUAL(fixed.Settled, 0);
+		UNIT_CHECK(fixed.Tracking <= 1.0);
+		UNIT_CHECK(fixed.Impulse <= 0 && fixed.Impulse > -(1 << shift));
+		UNIT_CHECK(legacy.Settled < 0); // The same checks catch the former gain error
+	}
+}
+
+int main(void) {
+	Unit_Case("running-sum boxcar equals the full-buffer average", TestBoxcarIdentical);
+	Unit_Case("IIR stage has unity gain and follows the exact low-pass", TestIirResponse);
+	return Unit_Finish();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file TestHost.c
+ * @brief Checks of the host build itself: the models against the firmware and a plain start-up.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+/**
+ * @brief The MT6701 model builds frames the firmware CRC check accepts, and only those.
+ */
+static void TestMt6701Crc(void) {
+	for (uint32_t data = 0; data < (1UL << 18); data++) {
+		uint32_t frame = Host_MT6701Frame(data >> 4, data & 0x0F);
+		uint32_t corrupted = frame ^ (1UL << (data % 24));
+
+		UNIT_EQUAL(MT6701CRC(&frame), 0);
+		UNIT_EQUAL(frame, data);
+		UNIT_EQUAL(MT6701CRC(&corrupted), 1);
+		if (UnitFailures) {
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Start-up: telemetry frames every 100 ms carrying the modelled sensor values.
+ */
+static void TestStartup(void) {
+	uint8_t text[64];
+	size_t position = 0;
+	size_t length;
+	uint64_t start;
+	uint64_t previous = 0;
+	unsigned frames = 0;
+	TelemetryFrame frame;
+
+	HostElevation.Code = 4096;  // 90 degrees
+	HostAzimuth.Code = 12288;   // 270 degrees
+	HostAnalog.SolarVoltage = 150.0;
+	HostAnalog.SolarCurrent = 2.0;
+	Host_SetPinA(4, 0);         // Y MAX closed
+
+	Host_Run(3000000); // The 20-sample boxcar filters settle within 2 s
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) != 0) {
+		UNIT_CHECK(Decode_Ascii(text, length, &frame));
+		if (frames) {
+			UNIT_NEAR((double)(start - previous) / HOST_F_CPU, 0.1, 0.0001);
+		}
+		previous = start;
+		frames++;
+	}
+	UNIT_NEAR(frames, 30, 1);
+	UNIT_EQUAL(frame.Elevation, MT6701_ELEVATION_REVERSED ? 27000 : 9000);
+	UNIT_EQUAL(frame.Azimuth, MT6701_AZIMUTH_REVERSED ? 9000 : 27000);
+	UNIT_NEAR(frame.Voltage, 1500, 2);
+	UNIT_NEAR(frame.Current, 200, 2);
+	UNIT_EQUAL(frame.EndSwitches, 2);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+int main(void) {
+	Unit_Case("MT6701 model frames pass the firmware CRC check", TestMt6701Crc);
+	Unit_Case("start-up sends telemetry with the modelled values", TestStartup);
+	return Unit_Finish();
+}
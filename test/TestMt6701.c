@@ -0,0 +1,238 @@
+/**
+ * @file TestMt6701.c
+ * @brief MT6701 angle conversion, SSI reads and angle processing.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "Unit.h"
+
+/**
+ * @brief Former conversion: code / 0.4551111111 + 0.5 truncated, then 36000 - angle if reversed.
+ *
+ * avr-gcc double is 32-bit, so the conversion is checked in float and in double.
+ */
+static uint16_t LegacyAngleDouble(uint16_t code, uint8_t reversed) {
+	uint16_t angle = ((double)code / 0.4551111111) + 0.5;
+	return reversed ? 36000 - angle : angle;
+}
+
+static uint16_t LegacyAngleFloat(uint16_t code, uint8_t reversed) {
+	uint16_t angle = ((float)code / 0.4551111111f) + 0.5f;
+	return reversed ? 36000 - angle : angle;
+}
+
+/**
+ * @brief Every 14-bit code in both directions and on both channels equals the former conversion.
+ */
+static void TestAngleExhaustive(void) {
+	static const uint16_t zeros[] = { 0, 1, 17999, 18000, 35999 };
+
+	for (uint8_t flags = 0; flags < 4; flags++) {
+		Calibration.Flags = flags;
+		for (uint8_t z = 0; z < sizeof(zeros) / sizeof(zeros[0]); z++) {
+			Calibration.AngleZero[0] = Calibration.AngleZero[1] = zeros[z];
+			for (uint16_t code = 0; code < 16384; code++) {
+				uint8_t elevationReversed = !!(flags & CALIBRATION_ELEVATION_REVERSED);
+				uint8_t azimuthReversed = !!(flags & CALIBRATION_AZIMUTH_REVERSED);
+				uint16_t elevation = LegacyAngleDouble(code, elevationReversed);
+				uint16_t azimuth = LegacyAngleDouble(code, azimuthReversed);
+
+				UNIT_EQUAL(LegacyAngleFloat(code, elevationReversed), elevation);
+				elevation = elevation >= zeros[z] ? elevation - zeros[z] : elevation + MT6701_FULL_TURN - zeros[z];
+				azimuth = azimuth >= zeros[z] ? azimuth - zeros[z] : azimuth + MT6701_FULL_TURN - zeros[z];
+				UNIT_EQUAL(MT6701_Angle(code, Elevation_Angle), elevation);
+				UNIT_EQUAL(MT6701_Angle(code, Azimuth_Angle), azimuth);
+				if (UnitFailures) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+#define ANGLES_RUNS 2048 ///< Angles task runs recorded
+
+static void (*angles_task)(void);
+static uint64_t angles_cycles;   ///< Longest Angles task run
+static uint64_t angles_sleep;    ///< Sleep cycles in that run
+static unsigned angles_runs;
+static uint8_t elevation_frames[ANGLES_RUNS]; ///< Elevation frames started in each run
+
+static void TimedAngles(void) {
+	uint64_t start = HostCycles;
+	uint64_t sleep = HostSleepCycles;
+	uint32_t frames = HostElevation.Frames;
+
+	angles_task();
+	if (HostCycles - start > angles_cycles) {
+		angles_cycles = HostCycles - start;
+		angles_sleep = HostSleepCycles - sleep;
+	}
+	if (angles_runs < ANGLES_RUNS) {
+		elevation_frames[angles_runs] = HostElevation.Frames - frames;
+	}
+	angles_runs++;
+}
+
+static void TimeAngles(void) {
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_Angles) {
+			angles_task = Tasks[i].Run;
+			Tasks[i].Run = TimedAngles;
+		}
+	}
+}
+
+/**
+ * @brief Both sensors are read with 24 SSI clocks back-to-back while the CPU sleeps.
+ *
+ * One read is three bytes at SSI_CLOCK_HZ without gaps between them; the task adds only
+ * the CSN handling and the conversion, and the CPU sleeps through the transfers.
+ */
+static void TestSsiTiming(void) {
+	const double transfer_us = 3 * 8 * 1e6 / SSI_CLOCK_HZ;
+	double task_us;
+	double sleep_us;
+
+	TimeAngles();
+	Host_Run(1000000);
+	task_us = (double)angles_cycles * 1e6 / HOST_F_CPU;
+	sleep_us = (double)angles_sleep * 1e6 / HOST_F_CPU;
+	printf("    %u runs, longest %.1f us (2 x %.0f us transfers), asleep %.1f us\n",
+		angles_runs, task_us, transfer_us, sleep_us);
+	UNIT_EQUAL(angles_runs, 1000 / TASK_ANGLES_PERIOD_MS);
+	UNIT_EQUAL(HostElevation.Frames, angles_runs); // No retries
+	UNIT_EQUAL(HostAzimuth.Frames, angles_runs);
+	UNIT_CHECK(task_us >= 2 * transfer_us);
+	UNIT_CHECK(task_us < 2 * transfer_us + 10); // No gaps between the bytes
+	UNIT_CHECK(sleep_us > 2 * transfer_us * 0.9);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief Runs the firmware over the given number of Angles task releases.
+ */
+static void Reads(unsigned count) {
+	Host_Run(count * TASK_ANGLES_PERIOD_MS * 1000);
+}
+
+/**
+ * @brief Injected CRC and field errors: retries, last-good hold, Age and the error counters.
+ */
+static void TestErrorInjection(void) {
+	uint32_t frames;
+	uint16_t good;
+
+	HostElevation.Code = 1000;
+	Reads(3);
+	good = MT6701_Angle(1000, Elevation_Angle);
+	UNIT_EQUAL(MT6701ELEVATION.Status, 0);
+	UNIT_EQUAL(MT6701ELEVATION.Angle, good);
+
+	HostElevation.Code = 2000; // Only seen through corrupted frames at first
+	HostElevation.CrcErrors = MT6701_READ_ATTEMPTS - 1; // Recovered by the last retry
+	frames = HostElevation.Frames;
+	Reads(1);
+	UNIT_EQUAL(HostElevation.Frames - frames, MT6701_READ_ATTEMPTS);
+	UNIT_EQUAL(MT6701ELEVATION.Status, 0);
+	UNIT_EQUAL(MT6701ELEVATION.Age, 0);
+	UNIT_EQUAL(MT6701ELEVATION.CommErrors, MT6701_READ_ATTEMPTS - 1);
+	good = MT6701_Angle(2000, Elevation_Angle);
+	UNIT_EQUAL(MT6701ELEVATION.Angle, good);
+
+	HostElevation.Code = 3000;
+	HostElevation.CrcErrors = 5 * MT6701_READ_ATTEMPTS; // Five reads fail completely
+	Reads(5);
+	UNIT_EQUAL(MT6701ELEVATION.Status, MT6701_STATUS_COMM | MT6701_STATUS_HOLD);
+	UNIT_EQUAL(MT6701ELEVATION.Age, 5);
+	UNIT_EQUAL(MT6701ELEVATION.Angle, good); // Corrupt angle never taken
+	UNIT_EQUAL(MT6701ELEVATION.CommErrors, 6 * MT6701_READ_ATTEMPTS - 1);
+
+	HostElevation.Field = 1; // Field too strong, the frame itself is intact
+	Reads(2);
+	UNIT_EQUAL(MT6701ELEVATION.Status, MT6701_STATUS_FIELD | MT6701_STATUS_HOLD);
+	UNIT_EQUAL(MT6701ELEVATION.Age, 7);
+	UNIT_EQUAL(MT6701ELEVATION.FieldErrors, 2 * MT6701_READ_ATTEMPTS);
+	UNIT_EQUAL(MT6701ELEVATION.Angle, good);
+
+	HostElevation.Field = 0;
+	HostElevation.Track = 1;
+	Reads(1);
+	UNIT_EQUAL(MT6701ELEVATION.Status, MT6701_STATUS_TRACK | MT6701_STATUS_HOLD);
+	UNIT_EQUAL(MT6701ELEVATION.Age, 8);
+	UNIT_EQUAL(MT6701ELEVATION.FieldErrors, 3 * MT6701_READ_ATTEMPTS);
+
+	HostElevation.Track = 0;
+	Reads(1);
+	UNIT_EQUAL(MT6701ELEVATION.Status, 0);
+	UNIT_EQUAL(MT6701ELEVATION.Age, 0);
+	UNIT_EQUAL(MT6701ELEVATION.Angle, MT6701_Angle(3000, Elevation_Angle));
+
+	UNIT_EQUAL(MT6701AZIMUTH.Status, 0); // The other sensor is not affected
+	UNIT_EQUAL(MT6701AZIMUTH.CommErrors + MT6701AZIMUTH.FieldErrors, 0);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief A missing sensor keeps the cycle time flat and is probed with a growing interval.
+ *
+ * An absent sensor costs one frame time when it is probed and nothing in between, so
+ * the longest Angles run never exceeds that of two working sensors.
+ */
+static void TestAbsentSensor(void) {
+	const double transfer_us = 3 * 8 * 1e6 / SSI_CLOCK_HZ;
+	unsigned previous = 0;
+	unsigned interval = 1;
+	unsigned probes = 0;
+	uint32_t azimuth;
+
+	TimeAngles();
+	HostElevation.Connected = 0;
+	Host_Run(10000000);
+	azimuth = HostAzimuth.Frames;
+	printf("    %u runs, %u elevation probes, longest %.1f us\n",
+		angles_runs, HostElevation.Frames, (double)angles_cycles * 1e6 / HOST_F_CPU);
+	UNIT_EQUAL(MT6701ELEVATION.Status, MT6701_STATUS_ABSENT);
+	UNIT_EQUAL(MT6701ELEVATION.Age, UINT8_MAX);
+	UNIT_EQUAL(MT6701ELEVATION.CommErrors + MT6701ELEVATION.FieldErrors, 0); // Not retried
+	UNIT_EQUAL(MT6701AZIMUTH.Status, 0);
+	UNIT_EQUAL(azimuth, angles_runs);
+	UNIT_CHECK((double)angles_cycles * 1e6 / HOST_F_CPU < 2 * transfer_us + 10);
+
+	for (unsigned run = 0; run < angles_runs && run < ANGLES_RUNS; run++) {
+		if (!elevation_frames[run]) {
+			continue;
+		}
+		UNIT_EQUAL(elevation_frames[run], 1);
+		if (probes) {
+			UNIT_EQUAL(run - previous, interval + 1); // Probe after 1, 2, 4, ... skipped reads
+			interval = interval < MT6701_PROBE_MAX_INTERVAL ? interval * 2 : interval;
+		}
+		previous = run;
+		probes++;
+	}
+	UNIT_EQUAL(probes, HostElevation.Frames);
+	UNIT_CHECK(interval == MT6701_PROBE_MAX_INTERVAL);
+
+	HostElevation.Connected = 1; // Found again at the next probe
+	Host_Run((MT6701_PROBE_MAX_INTERVAL + 1) * TASK_ANGLES_PERIOD_MS * 1000);
+	UNIT_EQUAL(MT6701ELEVATION.Status, 0);
+	UNIT_EQUAL(MT6701ELEVATION.ProbeInterval, 0);
+
+	angles_cycles = 0;
+	HostElevation.Connected = HostAzimuth.Connected = 0;
+	Host_Run(2000000);
+	UNIT_EQUAL(MT6701AZIMUTH.Status, MT6701_STATUS_ABSENT);
+	UNIT_CHECK((double)angles_cycles * 1e6 / HOST_F_CPU < 2 * transfer_us + 10);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+int main(void) {
+	Unit_Case("angle conversion equals the former formula for every code", TestAngleExhaustive);
+	Unit_Case("SSI frames are clocked back-to-back while the CPU sleeps", TestSsiTiming);
+	Unit_Case("CRC and field errors are retried, held and counted", TestErrorInjection);
+	Unit_Case("absent sensor: flat cycle time and probe back-off", TestAbsentSensor);
+	return Unit_Finish();
+}
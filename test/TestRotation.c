@@ -0,0 +1,304 @@
+/**
+ * @file TestRotation.c
+ * @brief Rotating magnet model: averaged angles, angular velocity and turn count in the binary frame.
+ *
+ * Both sensors see a magnet turning at a constant speed. The angle of a frame must be
+ * the mean of the exact angles at the sample times of its window and the velocity the
+ * exact speed, within the 14-bit code quantization, also across the 0/360 degree wrap.
+ * A multi-turn trajectory with field dropouts checks the azimuth turn count as a
+ * receiver unwraps it from Turns and Azimuth.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+#define CODE_CENTIDEGREES (36000.0 / 16384) ///< One MT6701 code in 0.01 degree
+
+static double speed;  ///< Magnet speed, degree per second (positive = increasing code)
+static double origin; ///< Magnet angle at time 0, degree
+
+/**
+ * @brief Exact magnet angle in 0.01 degree, as the firmware reports it (reversed by default).
+ */
+static double MagnetAngle(double seconds) {
+	double angle = fmod(100 * (origin + speed * seconds), 36000);
+
+	if (angle < 0) {
+		angle += 36000;
+	}
+	return MT6701_AZIMUTH_REVERSED ? 36000 - angle : angle;
+}
+
+static uint16_t MagnetCode(double seconds) {
+	double degrees = fmod(origin + speed * seconds, 360);
+
+	if (degrees < 0) {
+		degrees += 360;
+	}
+	return (uint16_t)(degrees / 360 * 16384) & 0x3FFF;
+}
+
+/**
+ * @brief Wrap-aware difference of two angles in 0.01 degree.
+ */
+static double AngleError(double angle, double exact) {
+	double error = fmod(angle - exact, 36000);
+
+	if (error > 18000) error -= 36000;
+	else if (error < -18000) error += 36000;
+	return error;
+}
+
+/**
+ * @brief Mean of the exact angles at the sample times of the window closed at `end`.
+ *
+ * The Angles task runs ahead of the telemetry task in the same tick, so the window holds
+ * the samples from end - 90 ms to end.
+ */
+static double WindowAngle(double end) {
+	const unsigned samples = TASK_TELEMETRY_PERIOD_MS / TASK_ANGLES_PERIOD_MS;
+	double first = MagnetAngle(end - (samples - 1) * TASK_ANGLES_PERIOD_MS / 1000.0);
+	double sum = 0;
+
+	for (unsigned i = 0; i < samples; i++) {
+		double t = end - (samples - 1 - i) * TASK_ANGLES_PERIOD_MS / 1000.0;
+		sum += AngleError(MagnetAngle(t), first); // Unwrapped against the first sample
+	}
+	return fmod(first + sum / samples + 36000, 36000);
+}
+
+/**
+ * @brief Runs the magnet for a while and checks every decoded frame.
+ *
+ * @param degreesPerSecond Magnet speed.
+ * @param seconds Run time.
+ */
+static void Rotate(double degreesPerSecond, double seconds) {
+	uint8_t encoded[64];
+	uint8_t payload[64];
+	size_t position = 0;
+	uint64_t start;
+	size_t length;
+	unsigned frames = 0;
+	double worstAngle = 0;
+	double worstVelocity = 0;
+	const double exactVelocity = (MT6701_AZIMUTH_REVERSED ? -100 : 100) * degreesPerSecond;
+
+	speed = degreesPerSecond;
+	origin = degreesPerSecond ? fmod(720 - 2 * degreesPerSecond, 360) : 350; // At 0/360 degree after 2 s
+	HostElevation.CodeAt = MagnetCode;
+	HostAzimuth.CodeAt = MagnetCode;
+	Host_Run(seconds * 1e6);
+
+	while ((length = Host_Uart1Frame(&position, 0x00, encoded, sizeof(encoded), &start)) != 0) {
+		TelemetryFrame frame;
+		double end = floor((double)start * 1000 / HOST_F_CPU) / 1000; // Tick of the telemetry task
+
+		UNIT_EQUAL(Decode_Cobs(encoded, length, payload), TELEMETRY_BINARY_PAYLOAD);
+		UNIT_EQUAL(Decode_Binary(payload, TELEMETRY_BINARY_PAYLOAD, &frame, NULL), 1);
+		if (frames++ < 2) {
+			continue; // First window is partial, the first velocity needs two windows
+		}
+		double angleError = fmax(fabs(AngleError(frame.Elevation, WindowAngle(end))),
+			fabs(AngleError(frame.Azimuth, WindowAngle(end)))); // Same magnet, read 48 us apart
+		double velocityError = fmax(fabs(frame.ElevationVelocity - exactVelocity),
+			fabs(frame.AzimuthVelocity - exactVelocity));
+		if (angleError > worstAngle) worstAngle = angleError;
+		if (velocityError > worstVelocity) worstVelocity = velocityError;
+	}
+	printf("    %+.1f deg/s: %u frames, worst angle error %.2f, velocity error %.1f (0.01 degree, /s)\n",
+		degreesPerSecond, frames, worstAngle, worstVelocity);
+	UNIT_EQUAL(frames, (unsigned)(seconds * 1000 - TASK_TELEMETRY_OFFSET_MS) / TASK_TELEMETRY_PERIOD_MS + 1);
+	UNIT_CHECK(worstAngle <= CODE_CENTIDEGREES); // Codes are truncated, the conversion rounds
+	UNIT_CHECK(worstVelocity <= 2 * CODE_CENTIDEGREES * 1000 / TASK_TELEMETRY_PERIOD_MS); // Two averages, each within one code
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief Multi-turn trajectory: 10 s forward at 120 degree/s, then 15 s back.
+ */
+static double TurnDegrees(double seconds) {
+	return 10 + (seconds < 10 ? 120 * seconds : 1200 - 120 * (seconds - 10));
+}
+
+static uint16_t TurnCode(double seconds) {
+	double degrees = fmod(TurnDegrees(seconds), 360);
+
+	if (degrees < 0) {
+		degrees += 360;
+	}
+	return (uint16_t)(degrees / 360 * 16384) & 0x3FFF;
+}
+
+/**
+ * @brief Exact unwrapped azimuth position as the firmware reports it, in 0.01 degree.
+ *
+ * The first good angle seeds the position within 0 to 35999: 350.00 degree reversed
+ * (origin 10 degree), 10.00 degree otherwise.
+ */
+static double TurnPosition(double seconds) {
+	return MT6701_AZIMUTH_REVERSED ? 36000 - 100 * TurnDegrees(seconds) : 100 * TurnDegrees(seconds);
+}
+
+/**
+ * @brief Azimuth dropouts: field loss from Start for Length seconds.
+ */
+typedef struct {
+	double Start;
+	double Length;
+} DROPOUT;
+
+static const DROPOUT *dropouts;
+static uint8_t dropout_count;
+
+static void FieldLost(void) {
+	HostAzimuth.Field = 1; // Every read attempt fails, the angle is held
+}
+
+static void FieldBack(void) {
+	HostAzimuth.Field = 0;
+}
+
+/**
+ * @brief 1 if a read of the window closed at `end` may have failed.
+ */
+static uint8_t InDropout(double end) {
+	for (uint8_t i = 0; i < dropout_count; i++) {
+		if (end - TASK_TELEMETRY_PERIOD_MS / 1000.0 < dropouts[i].Start + dropouts[i].Length + 0.02
+			&& end > dropouts[i].Start - 0.02) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Runs the multi-turn trajectory with the given dropouts and unwraps every frame as a receiver does.
+ *
+ * @param list Dropouts.
+ * @param count Number of dropouts.
+ * @param worst Receives the worst position error of the frames after the last dropout.
+ * @return Number of frames checked against the exact position.
+ */
+static unsigned Turn(const DROPOUT *list, uint8_t count, double *worst) {
+	uint8_t encoded[64];
+	uint8_t payload[64];
+	size_t position = 0;
+	uint64_t start;
+	size_t length;
+	unsigned frames = 0;
+	unsigned checked = 0;
+	int minTurns = 0;
+	int maxTurns = 0;
+	double previous = 0;
+	const unsigned samples = TASK_TELEMETRY_PERIOD_MS / TASK_ANGLES_PERIOD_MS;
+
+	dropouts = list;
+	dropout_count = count;
+	for (uint8_t i = 0; i < count; i++) {
+		Host_At(HOST_US(list[i].Start * 1e6), FieldLost);
+		Host_At(HOST_US((list[i].Start + list[i].Length) * 1e6), FieldBack);
+	}
+	HostAzimuth.CodeAt = TurnCode;
+	Host_Run(25000000);
+
+	*worst = 0;
+	while ((length = Host_Uart1Frame(&position, 0x00, encoded, sizeof(encoded), &start)) != 0) {
+		TelemetryFrame frame;
+		double end = floor((double)start * 1000 / HOST_F_CPU) / 1000;
+		double reconstructed;
+		double exact = 0;
+
+		UNIT_EQUAL(Decode_Cobs(encoded, length, payload), TELEMETRY_BINARY_PAYLOAD);
+		UNIT_EQUAL(Decode_Binary(payload, TELEMETRY_BINARY_PAYLOAD, &frame, NULL), 1);
+		reconstructed = (double)frame.AzimuthTurns * MT6701_FULL_TURN + frame.Azimuth; // Receiver side
+		if (frames++ < 1) {
+			previous = reconstructed;
+			continue; // First window is partial
+		}
+		UNIT_CHECK(fabs(reconstructed - previous) < MT6701_FULL_TURN / 2); // Continuous, no jump by a turn
+		previous = reconstructed;
+		if (frame.AzimuthTurns < minTurns) minTurns = frame.AzimuthTurns;
+		if (frame.AzimuthTurns > maxTurns) maxTurns = frame.AzimuthTurns;
+		if (InDropout(end)) {
+			continue; // Window with held or missing samples
+		}
+		for (unsigned i = 0; i < samples; i++) {
+			exact += TurnPosition(end - (samples - 1 - i) * TASK_ANGLES_PERIOD_MS / 1000.0) / samples;
+		}
+		if (!count || end > list[count - 1].Start + list[count - 1].Length) {
+			if (fabs(reconstructed - exact) > *worst) *worst = fabs(reconstructed - exact);
+		}
+		else {
+			UNIT_CHECK(fabs(reconstructed - exact) <= CODE_CENTIDEGREES);
+		}
+		checked++;
+	}
+	printf("    %u dropouts: %u frames, %u checked, turns %d to %d, worst error after the last dropout %.2f (0.01 degree)\n",
+		count, frames, checked, minTurns, maxTurns, *worst);
+	UNIT_EQUAL(frames, (25000 - TASK_TELEMETRY_OFFSET_MS) / TASK_TELEMETRY_PERIOD_MS + 1);
+	UNIT_CHECK(minTurns <= -2 && maxTurns >= 2); // Both directions across several turns
+	UNIT_EQUAL(HostErrors, 0);
+	return checked;
+}
+
+static void TestStanding(void) {
+	Rotate(0, 2);
+}
+
+static void TestSlow(void) {
+	Rotate(0.5, 10);
+}
+
+static void TestTracking(void) {
+	Rotate(-12, 10);
+}
+
+static void TestFast(void) {
+	Rotate(90, 10);
+}
+
+/**
+ * @brief Turns survive dropouts while the magnet moves less than half a turn in them.
+ */
+static void TestTurnsDropouts(void) {
+	static const DROPOUT list[] = {
+		{ 2.005, 0.25 },  // 30 degree
+		{ 6.5, 1.2 },     // 144 degree
+		{ 9.7, 0.6 },     // Across the reversal
+		{ 13.33, 0.035 }, // A few reads
+		{ 18.0, 1.4 }     // 168 degree
+	};
+	double worst;
+
+	UNIT_CHECK(Turn(list, sizeof(list) / sizeof(list[0]), &worst) > 150);
+	UNIT_CHECK(worst <= CODE_CENTIDEGREES);
+	UNIT_CHECK(MT6701AZIMUTH.Status == 0);
+}
+
+/**
+ * @brief A dropout longer than half a turn loses exactly one turn (documented limit).
+ */
+static void TestTurnsLongDropout(void) {
+	static const DROPOUT list[] = {
+		{ 4.0, 2.0 } // 240 degree, unwrapped as 120 degree the other way
+	};
+	double worst;
+
+	Turn(list, 1, &worst);
+	UNIT_NEAR(worst, MT6701_FULL_TURN, CODE_CENTIDEGREES);
+}
+
+int main(void) {
+	Unit_Case("standing magnet", TestStanding);
+	Unit_Case("slow rotation across 0/360 degree", TestSlow);
+	Unit_Case("reverse rotation across 0/360 degree", TestTracking);
+	Unit_Case("fast rotation, several wraps", TestFast);
+	Unit_Case("turn count across dropouts", TestTurnsDropouts);
+	Unit_Case("turn lost in a dropout over half a turn", TestTurnsLongDropout);
+	return Unit_Finish();
+}
@@ -0,0 +1,152 @@
+/**
+ * @file TestScheduler.c
+ * @brief Telemetry release times under changing task load.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "Unit.h"
+
+#define RELEASES 64 ///< Telemetry releases recorded
+
+static void (*solar_task)(void);
+static void (*energy_task)(void);
+static void (*telemetry_task)(void);
+static uint64_t releases[RELEASES];
+static unsigned release_count;
+static uint64_t busy_us;
+static uint32_t overrun_us; ///< One-time SolarCells overrun, started after 1 s
+
+static uint32_t random_state = 0x6C078965;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief SolarCells with 0 to 25 ms of extra work.
+ *
+ * Together with the Energy releases it delays, it ends well before the telemetry tick.
+ */
+static void LoadedSolar(void) {
+	uint32_t us = Random() % 25000;
+
+	if (overrun_us && Host_Seconds() > 1.0) {
+		us = overrun_us;
+		overrun_us = 0;
+	}
+	solar_task();
+	Host_Busy(us);
+	busy_us += us;
+}
+
+/**
+ * @brief Energy with 0 to 2 ms of extra work.
+ */
+static void LoadedEnergy(void) {
+	uint32_t us = Random() % 2000;
+
+	energy_task();
+	Host_Busy(us);
+	busy_us += us;
+}
+
+static void RecordedTelemetry(void) {
+	if (release_count < RELEASES) {
+		releases[release_count++] = HostCycles;
+	}
+	telemetry_task();
+}
+
+static void Setup(void) {
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_SolarCells) {
+			solar_task = Tasks[i].Run;
+			Tasks[i].Run = LoadedSolar;
+		}
+		else if (Tasks[i].Run == Task_Energy) {
+			energy_task = Tasks[i].Run;
+			Tasks[i].Run = LoadedEnergy;
+		}
+		else if (Tasks[i].Run == Task_Telemetry) {
+			telemetry_task = Tasks[i].Run;
+			Tasks[i].Run = RecordedTelemetry;
+		}
+	}
+}
+
+/**
+ * @brief Offset of a release from its slot on the fixed 100 ms grid, seconds.
+ */
+static double GridError(unsigned index) {
+	double elapsed = (double)(releases[index] - releases[0]) / HOST_F_CPU;
+	return elapsed - index * (TASK_TELEMETRY_PERIOD_MS / 1000.0);
+}
+
+/**
+ * @brief Releases stay on the 100 ms grid while the other tasks take 0 to 45% of the CPU.
+ */
+static void TestFixedPeriod(void) {
+	double worst = 0;
+	size_t position = 0;
+	uint8_t text[64];
+	uint64_t start;
+	uint64_t previous = 0;
+	unsigned frames = 0;
+
+	Setup();
+	Host_Run(5000000);
+	UNIT_EQUAL(release_count, 50);
+	for (unsigned i = 1; i < release_count; i++) {
+		double error = fabs(GridError(i));
+		if (error > worst) {
+			worst = error;
+		}
+	}
+	printf("    extra task work %.2f s in %.0f s, worst release offset %.1f us\n",
+		busy_us / 1e6, Host_Seconds(), worst * 1e6);
+	UNIT_CHECK(busy_us > 500000); // A delay loop would have drifted by all of this
+	UNIT_CHECK(worst < 100e-6);
+
+	while (Host_Uart1Frame(&position, '\n', text, sizeof(text), &start)) {
+		if (frames) {
+			UNIT_NEAR((double)(start - previous) / HOST_F_CPU, 0.1, 100e-6);
+		}
+		previous = start;
+		frames++;
+	}
+	UNIT_NEAR(frames, 50, 1);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief After a 250 ms overrun the missed releases run at once and the grid phase is kept.
+ */
+static void TestOverrun(void) {
+	unsigned late = 0;
+
+	Setup();
+	overrun_us = 250000;
+	Host_Run(5000000);
+	UNIT_EQUAL(release_count, 50); // None lost
+	for (unsigned i = 1; i < release_count; i++) {
+		double error = GridError(i);
+		if (error > 100e-6) {
+			late++;
+		}
+		UNIT_CHECK(error > -100e-6); // Never early
+	}
+	printf("    releases off the grid after the overrun: %u\n", late);
+	UNIT_CHECK(late >= 1 && late <= 3);
+	UNIT_CHECK(fabs(GridError(release_count - 1)) < 100e-6);
+}
+
+int main(void) {
+	Unit_Case("telemetry keeps its period under changing task load", TestFixedPeriod);
+	Unit_Case("an overrun does not shift the schedule", TestOverrun);
+	return Unit_Finish();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file TestSerializer.c
+ * @brief ASCII frame serializer against the former snprintf frame path.
+ *
+ * Telemetry.c is included so that its static serializer can be called directly; the
+ * USART1 functions it sends through are replaced by a capture buffer.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "../Attiny1624-Tower-Top-Controller/Telemetry.c"
+#include "Bench.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+/**
+ * @brief Format string of the former USART1_printf() frame path.
+ */
+#define LEGACY_FORMAT "<%04x%04x%03x%03x%x%02x>\r\n"
+
+static char captured[64];
+static uint8_t capturedLength;
+
+uint8_t USART1_write(const char *data, uint8_t length) {
+	memcpy(captured, data, length);
+	capturedLength = length;
+	return 1;
+}
+
+uint8_t USART1_writePriority(const char *data, uint8_t length) {
+	return USART1_write(data, length);
+}
+
+static uint32_t random_state = 0x9E3779B9;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Random frame fields within their widths.
+ */
+static TelemetryFrame RandomFrame(void) {
+	uint32_t a = Random();
+	uint32_t b = Random();
+	TelemetryFrame frame = {
+		.Elevation = a,
+		.Azimuth = a >> 16,
+		.Voltage = b & 0x0FFF,
+		.Current = (b >> 12) & 0x0FFF,
+		.EndSwitches = (b >> 24) & 0x0F,
+	};
+	return frame;
+}
+
+/**
+ * @brief Packed field bytes covered by the ASCII frame CRC.
+ */
+static uint8_t FieldsCrc(const TelemetryFrame *frame) {
+	uint8_t fields[TELEMETRY_FIELD_BYTES] = {
+		frame->Elevation >> 12, frame->Elevation >> 4,
+		(frame->Elevation << 4) | (frame->Azimuth >> 12), frame->Azimuth >> 4,
+		(frame->Azimuth << 4) | (frame->Voltage >> 8), frame->Voltage,
+		frame->Current >> 4, (frame->Current << 4) | frame->EndSwitches,
+	};
+	return Decode_Crc8(fields, sizeof(fields));
+}
+
+/**
+ * @brief Telemetry_Send() output equals the old snprintf frame, CRC over the packed fields.
+ */
+static void TestIdentical(void) {
+	char expected[32]; // Former PrintfBufferSize
+
+	for (uint32_t i = 0; i < 1000000 && !UnitFailures; i++) {
+		TelemetryFrame frame = RandomFrame();
+
+		if (i < 16) {
+			frame.Elevation = i & 1 ? 0xFFFF : 0; // Edges of every field width
+			frame.Azimuth = i & 2 ? 0xFFFF : 0;
+			frame.Voltage = frame.Current = i & 4 ? 0x0FFF : 0;
+			frame.EndSwitches = i & 8 ? 0x0F : 0;
+		}
+		snprintf(expected, sizeof(expected), LEGACY_FORMAT, frame.Elevation, frame.Azimuth,
+			frame.Voltage, frame.Current, frame.EndSwitches, FieldsCrc(&frame));
+		Telemetry_Send(&frame);
+		UNIT_EQUAL(capturedLength, TELEMETRY_ASCII_FRAME);
+		UNIT_EQUAL(strlen(expected), TELEMETRY_ASCII_FRAME);
+		UNIT_CHECK(!memcmp(captured, expected, TELEMETRY_ASCII_FRAME));
+	}
+}
+
+static TelemetryFrame bench_frames[256];
+
+static void BenchPrintf(uint32_t i) {
+	const TelemetryFrame *frame = &bench_frames[i & 0xFF];
+	char buffer[32];
+
+	snprintf(buffer, sizeof(buffer), LEGACY_FORMAT, frame->Elevation, frame->Azimuth,
+		frame->Voltage, frame->Current, frame->EndSwitches, i & 0xFF);
+	BenchSink += buffer[i % TELEMETRY_ASCII_FRAME];
+}
+
+static void BenchSerializer(uint32_t i) {
+	const TelemetryFrame *frame = &bench_frames[i & 0xFF];
+	char buffer[TELEMETRY_ASCII_FRAME];
+
+	Telemetry_PackAscii(frame, i & 0xFF, buffer);
+	BenchSink += buffer[i % TELEMETRY_ASCII_FRAME];
+}
+
+/**
+ * @brief Host CPU time per frame of both paths (formatting only, CRC excluded).
+ *
+ * Host glibc snprintf stands in for avr-libc vfprintf: both parse the format string at
+ * run time, so the ratio shows the cost removed, not the ATtiny1624 cycle count.
+ */
+static void TestBenchmark(void) {
+	double printf_ns;
+	double serializer_ns;
+
+	for (unsigned i = 0; i < 256; i++) {
+		bench_frames[i] = RandomFrame();
+	}
+	printf_ns = Bench_Run(BenchPrintf, 200000, 5);
+	serializer_ns = Bench_Run(BenchSerializer, 200000, 5);
+	printf("    snprintf: %.1f ns/frame, serializer: %.1f ns/frame, ratio %.1f\n",
+		printf_ns, serializer_ns, printf_ns / serializer_ns);
+	UNIT_CHECK(serializer_ns * 3 < printf_ns);
+}
+
+int main(void) {
+	Unit_Case("serializer output equals the snprintf frame", TestIdentical);
+	Unit_Case("serializer is faster than snprintf", TestBenchmark);
+	return Unit_Finish();
+}
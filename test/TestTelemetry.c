@@ -0,0 +1,150 @@
+/**
+ * @file TestTelemetry.c
+ * @brief Binary telemetry frame round trips through the receiver side decoder.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "TelemetryDecode.h"
+#include "Unit.h"
+
+/**
+ * @brief Deterministic pseudo-random sequence (xorshift32).
+ */
+static uint32_t random_state = 0x2545F491;
+
+static uint32_t Random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Encodes and decodes one block, checks the result and the encoded form.
+ */
+static void RoundTrip(const uint8_t *data, uint8_t length) {
+	uint8_t encoded[256];
+	uint8_t decoded[256];
+	uint8_t encodedLength = COBS_Encode(data, length, encoded);
+
+	UNIT_EQUAL(encodedLength, length + 2);
+	UNIT_EQUAL(encoded[encodedLength - 1], 0x00);
+	UNIT_CHECK(memchr(encoded, 0x00, encodedLength - 1) == NULL);
+	UNIT_EQUAL(Decode_Cobs(encoded, encodedLength, decoded), length);
+	UNIT_CHECK(!memcmp(decoded, data, length));
+}
+
+/**
+ * @brief COBS_Encode() against the decoder: random blocks, zero runs and the longest non-zero run.
+ */
+static void TestCobs(void) {
+	uint8_t data[253];
+
+	for (unsigned i = 0; i < 20000 && !UnitFailures; i++) {
+		uint8_t length = Random() % (sizeof(data) + 1);
+		uint8_t zeros = Random() % 4; // 0: no zero bytes, 3: mostly zero bytes
+
+		for (uint8_t j = 0; j < length; j++) {
+			data[j] = Random() % 4 < zeros ? 0x00 : (Random() % 255) + 1;
+		}
+		RoundTrip(data, length);
+	}
+
+	memset(data, 0x00, sizeof(data));
+	RoundTrip(data, sizeof(data));
+	RoundTrip(data, 0);
+	memset(data, 0xA5, sizeof(data));
+	RoundTrip(data, sizeof(data)); // Single block, code byte 0xFE
+	data[0] = 0x00;
+	RoundTrip(data, sizeof(data)); // Zero, then 252 non-zero bytes
+	data[0] = 0xA5;
+	data[sizeof(data) - 1] = 0x00;
+	RoundTrip(data, sizeof(data)); // 252 non-zero bytes, then a trailing zero
+}
+
+/**
+ * @brief The decoder rejects frames whose code bytes do not add up.
+ */
+static void TestCobsMalformed(void) {
+	static const uint8_t pastEnd[] = {0x05, 0x11, 0x22, 0x00};
+	static const uint8_t innerZero[] = {0x03, 0x11, 0x00, 0x22, 0x00};
+	uint8_t decoded[8];
+
+	UNIT_EQUAL(Decode_Cobs(pastEnd, sizeof(pastEnd), decoded), -1);
+	UNIT_EQUAL(Decode_Cobs(innerZero, sizeof(innerZero), decoded), -1);
+}
+
+/**
+ * @brief Random field values, biased towards 0, all ones and values with zero bytes.
+ */
+static uint32_t RandomField(uint32_t mask) {
+	switch (Random() % 4) {
+		case 0: return 0;
+		case 1: return mask;
+		case 2: return Random() & mask & 0xFF00FF00UL;
+		default: return Random() & mask;
+	}
+}
+
+/**
+ * @brief Telemetry_Send() in binary format: every field survives the line and the decoder.
+ */
+static void TestFrames(void) {
+	uint8_t encoded[64];
+	uint8_t payload[64];
+	size_t position = 0;
+	uint8_t expectedSequence = 0;
+
+	USART1_init();
+	sei();
+	for (unsigned i = 0; i < 2000 && !UnitFailures; i++) {
+		TelemetryFrame sent = {
+			.Elevation = RandomField(0xFFFF),
+			.Azimuth = RandomField(0xFFFF),
+			.Voltage = RandomField(0x0FFF),
+			.Current = RandomField(0x0FFF),
+			.EndSwitches = RandomField(0x0F),
+			.Status = RandomField(0xFF),
+			.ElevationVelocity = (int16_t)RandomField(0xFFFF),
+			.AzimuthVelocity = (int16_t)RandomField(0xFFFF),
+			.Energy = RandomField(0xFFFFFFFFUL),
+			.AzimuthTurns = (int16_t)RandomField(0xFFFF),
+		};
+		TelemetryFrame received;
+		uint8_t sequence;
+		size_t length;
+		int decoded;
+
+		Telemetry_Send(&sent);
+		Host_Busy(1000);
+		length = Host_Uart1Frame(&position, 0x00, encoded, sizeof(encoded), NULL);
+		UNIT_EQUAL(length, TELEMETRY_BINARY_FRAME);
+		decoded = Decode_Cobs(encoded, length, payload);
+		UNIT_EQUAL(decoded, TELEMETRY_BINARY_PAYLOAD);
+		UNIT_EQUAL(Decode_Binary(payload, decoded, &received, &sequence), 1);
+		UNIT_EQUAL(sequence, expectedSequence++);
+		UNIT_EQUAL(received.Elevation, sent.Elevation);
+		UNIT_EQUAL(received.Azimuth, sent.Azimuth);
+		UNIT_EQUAL(received.Voltage, sent.Voltage);
+		UNIT_EQUAL(received.Current, sent.Current);
+		UNIT_EQUAL(received.EndSwitches, sent.EndSwitches);
+		UNIT_EQUAL(received.Status, sent.Status);
+		UNIT_EQUAL(received.ElevationVelocity, sent.ElevationVelocity);
+		UNIT_EQUAL(received.AzimuthVelocity, sent.AzimuthVelocity);
+		UNIT_EQUAL(received.Energy, sent.Energy);
+		UNIT_EQUAL(received.AzimuthTurns, sent.AzimuthTurns);
+
+		payload[1 + Random() % (TELEMETRY_BINARY_PAYLOAD - 1)] ^= 1 << (Random() % 8);
+		UNIT_EQUAL(Decode_Binary(payload, decoded, &received, NULL), 0); // Single bit errors are detected
+	}
+	UNIT_EQUAL(USART1TX.overflowCount, 0);
+}
+
+int main(void) {
+	Unit_Case("COBS round trip", TestCobs);
+	Unit_Case("COBS decoder rejects malformed frames", TestCobsMalformed);
+	Unit_Case("binary frame round trip", TestFrames);
+	return Unit_Finish();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file TestUsart1.c
+ * @brief USART1 ring buffer transmission: non-blocking enqueue, overflow, priority frames.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Settings.h"
+#include "Unit.h"
+
+static const char frame[] = "<0123456789abcdef0>\r\n";
+
+/**
+ * @brief USART1 alone, interrupts enabled.
+ */
+static void Setup(void) {
+	USART1_init();
+	sei();
+}
+
+/**
+ * @brief Checks that the captured bytes from index `first` are `data`, sent back-to-back.
+ */
+static void CheckLine(size_t first, const char *data, size_t length) {
+	UNIT_CHECK(Host_Uart1Count() >= first + length);
+	for (size_t i = 0; i < length && first + i < Host_Uart1Count(); i++) {
+		UNIT_EQUAL(Host_Uart1Byte(first + i)->Data, (uint8_t)data[i]);
+		if (i) {
+			UNIT_EQUAL(Host_Uart1Byte(first + i)->Start - Host_Uart1Byte(first + i - 1)->Start, Host_Uart1ByteCycles());
+		}
+	}
+}
+
+/**
+ * @brief Queueing a frame returns long before its first byte has left, the line carries it unchanged.
+ */
+static void TestNonBlocking(void) {
+	uint64_t start;
+	uint64_t spent;
+
+	Setup();
+	start = HostCycles;
+	UNIT_EQUAL(USART1_write(frame, sizeof(frame) - 1), 1);
+	spent = HostCycles - start;
+	printf("    enqueue of %u bytes: %llu CPU cycles, transmission: %llu cycles\n", (unsigned)(sizeof(frame) - 1),
+		(unsigned long long)spent, (unsigned long long)(Host_Uart1ByteCycles() * (sizeof(frame) - 1)));
+	UNIT_CHECK(spent < Host_Uart1ByteCycles());
+
+	Host_Busy(1000);
+	CheckLine(0, frame, sizeof(frame) - 1);
+	UNIT_EQUAL(Host_Uart1Count(), sizeof(frame) - 1);
+	UNIT_EQUAL(USART1TX.head, USART1TX.tail);
+	UNIT_EQUAL(HostErrors, 0);
+}
+
+/**
+ * @brief Blocks that do not fit are dropped whole and counted; the queued ones go out complete.
+ */
+static void TestOverflow(void) {
+	uint8_t queued = 0;
+	uint8_t dropped = 0;
+	uint8_t text[64];
+	size_t position = 0;
+	size_t length;
+	unsigned frames = 0;
+
+	Setup();
+	cli(); // Nothing drains while the buffer is filled
+	for (uint8_t i = 0; i < 5; i++) {
+		if (USART1_write(frame, sizeof(frame) - 1)) queued++;
+		else dropped++;
+	}
+	sei();
+	UNIT_EQUAL(queued, (USART1_TX_BUFFER_SIZE - 1) / sizeof(frame)); // Length byte + frame per block
+	UNIT_EQUAL(dropped, 5 - queued);
+	UNIT_EQUAL(USART1TX.overflowCount, dropped);
+
+	Host_Busy(5000);
+	while ((length = Host_Uart1Frame(&position, '\n', text, sizeof(text), NULL)) != 0) {
+		UNIT_EQUAL(length, sizeof(frame) - 1);
+		UNIT_CHECK(!memcmp(text, frame, sizeof(frame) - 1));
+		frames++;
+	}
+	UNIT_EQUAL(frames, queued);
+	UNIT_EQUAL(position, Host_Uart1Count());
+}
+
+/**
+ * @brief A priority frame goes out at the next block boundary, ahead of the queued blocks.
+ */
+static void TestPriority(void) {
+	static const char urgent[] = "!0112\r\n";
+	uint64_t queued;
+	size_t first = sizeof(frame) - 1;
+
+	Setup();
+	USART1_write(frame, sizeof(frame) - 1);
+	USART1_write(frame, sizeof(frame) - 1);
+	Host_Busy(5); // First frame is on the line
+	queued = HostCycles;
+	UNIT_EQUAL(USART1_writePriority(urgent, sizeof(urgent) - 1), 1);
+	Host_Busy(2000);
+
+	CheckLine(0, frame, sizeof(frame) - 1);
+	CheckLine(first, urgent, sizeof(urgent) - 1);
+	CheckLine(first + sizeof(urgent) - 1, frame, sizeof(frame) - 1);
+	UNIT_CHECK(Host_Uart1Byte(first)->Start - queued <= Host_Uart1ByteCycles() * first);
+}
+
+/**
+ * @brief USART1_flush() returns once the last byte has left the shift register.
+ */
+static void TestFlush(void) {
+	Setup();
+	USART1_sendString("ab");
+	Host_Busy(1); // Both bytes are in the transmitter, the ring buffer is empty
+	USART1_flush();
+	UNIT_EQUAL(Host_Uart1Count(), 2);
+	UNIT_CHECK(HostCycles >= Host_Uart1Byte(1)->Start + Host_Uart1ByteCycles());
+	UNIT_CHECK(HostCycles <= Host_Uart1Byte(1)->Start + Host_Uart1ByteCycles() + 2 * HOST_ACCESS_CYCLES);
+	UNIT_EQUAL(USART1TX.inFlight, 0);
+}
+
+/**
+ * @brief In the running firmware the telemetry task takes a small part of one byte time.
+ */
+static void (*telemetry_task)(void);
+static uint64_t telemetry_longest;
+
+static void TimedTelemetry(void) {
+	uint64_t start = HostCycles;
+
+	telemetry_task();
+	if (HostCycles - start > telemetry_longest) {
+		telemetry_longest = HostCycles - start;
+	}
+}
+
+static void TestTaskTime(void) {
+	for (uint8_t i = 0; i < SCHEDULER_TASKS; i++) {
+		if (Tasks[i].Run == Task_Telemetry) {
+			telemetry_task = Tasks[i].Run;
+			Tasks[i].Run = TimedTelemetry;
+		}
+	}
+	Host_Run(1000000);
+	printf("    longest telemetry task: %llu register access cycles\n", (unsigned long long)telemetry_longest);
+	UNIT_CHECK(telemetry_longest > 0);
+	UNIT_CHECK(telemetry_longest < Host_Uart1ByteCycles());
+	UNIT_NEAR(Host_Uart1Count(), 10 * TELEMETRY_ASCII_FRAME, TELEMETRY_ASCII_FRAME);
+}
+
+int main(void) {
+	Unit_Case("enqueue returns before the frame is sent", TestNonBlocking);
+	Unit_Case("full buffer drops whole blocks and counts them", TestOverflow);
+	Unit_Case("priority frame goes first at the next block boundary", TestPriority);
+	Unit_Case("flush waits for the shift register", TestFlush);
+	Unit_Case("telemetry task does not wait for the line", TestTaskTime);
+	return Unit_Finish();
+}
@@ -0,0 +1,36 @@
+/**
+ * @file Bench.c
+ * @brief CPU time measurement for the host benchmarks.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Bench.h"
+#include <time.h>
+
+volatile uint32_t BenchSink;
+
+uint64_t Bench_Nanoseconds(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+double Bench_Run(void (*body)(uint32_t iteration), uint32_t iterations, uint8_t rounds) {
+	uint64_t best = UINT64_MAX;
+
+	while (rounds--) {
+		uint64_t start = Bench_Nanoseconds();
+		uint64_t spent;
+
+		for (uint32_t i = 0; i < iterations; i++) {
+			body(i);
+		}
+		spent = Bench_Nanoseconds() - start;
+		if (spent < best) {
+			best = spent;
+		}
+	}
+	return (double)best / iterations;
+}
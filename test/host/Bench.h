@@ -0,0 +1,38 @@
+/**
+ * @file Bench.h
+ * @brief CPU time measurement for the host benchmarks.
+ *
+ * The host has neither an AVR simulator nor usable performance counters, so benchmarks
+ * compare thread CPU time of two implementations built the same way. The absolute
+ * figures say nothing about the ATtiny1624; only the ratios are meaningful.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Thread CPU time in nanoseconds.
+ */
+uint64_t Bench_Nanoseconds(void);
+
+/**
+ * @brief Times a function over a number of calls.
+ *
+ * @param body Function under test, called with the iteration index.
+ * @param iterations Calls per round.
+ * @param rounds Number of rounds; the fastest one is kept to reject scheduling noise.
+ * @return CPU time per call in nanoseconds.
+ */
+double Bench_Run(void (*body)(uint32_t iteration), uint32_t iterations, uint8_t rounds);
+
+/**
+ * @brief Keeps a computed value alive so the compiler cannot drop the work.
+ */
+extern volatile uint32_t BenchSink;
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,993 @@
+/**
+ * @file Host.c
+ * @brief Host models of the ATtiny1624 peripherals and the virtual clock.
+ *
+ * All models work on one event loop in CPU cycles. Firmware register accesses are
+ * detected on the next Host_Access() (strobe registers read back with HOST_UNWRITTEN
+ * set, configuration registers are compared with their last published value), so a
+ * write takes effect before the next access of any peripheral, in program order.
+ *
+ * The firmware runs on its own stack (ucontext), so Host_Run() can stop it at any sleep
+ * or busy-wait once the requested time has passed and continue it later from there.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#define _GNU_SOURCE
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <ucontext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Register blocks */
+PORT_t HostPORTA;
+PORT_t HostPORTB;
+PORTMUX_t HostPORTMUX;
+CLKCTRL_t HostCLKCTRL;
+EVSYS_t HostEVSYS;
+TCA_t HostTCA0;
+TCB_t HostTCB0;
+USART_t HostUSART0;
+USART_t HostUSART1;
+ADC_t HostADC0;
+USERROW_t HostUSERROW;
+
+/* CPU */
+uint8_t HostInterrupts = 0;
+uint8_t HostSleepEnabled = 0;
+uint8_t HostSleepMode = 0;
+uint64_t HostCycles = 0;
+uint64_t HostSleepCycles = 0;
+uint32_t HostErrors = 0;
+
+/* Interrupt vectors defined by the firmware (weak: a build may leave one out) */
+void HostVector_PORTA_PORT(void) __attribute__((weak));
+void HostVector_TCB0_INT(void) __attribute__((weak));
+void HostVector_USART0_RXC(void) __attribute__((weak));
+void HostVector_ADC0_RESRDY(void) __attribute__((weak));
+void HostVector_USART1_DRE(void) __attribute__((weak));
+
+int Firmware_Main(void);
+
+#define HOST_NEVER UINT64_MAX
+#define HOST_ACTIONS 64
+#define HOST_ISR_STORM 10000
+#define HOST_FIRMWARE_STACK (1024 * 1024)
+
+static uint8_t host_in_isr;
+
+/**
+ * @brief Stops the test with a model error message (misuse that real hardware would not survive).
+ */
+static void Host_Fatal(const char *message) {
+	fprintf(stderr, "host model: %s at %.6f s\n", message, (double)HostCycles / HOST_F_CPU);
+	abort();
+}
+
+/**
+ * @brief Returns 1 and the written value if the firmware wrote a strobe register, and re-arms it.
+ */
+static uint8_t Host_Written(register16_t *reg, uint8_t *value) {
+	uint16_t v = *reg;
+
+	if (v & HOST_UNWRITTEN) {
+		return 0;
+	}
+	*value = (uint8_t)v;
+	*reg = HOST_UNWRITTEN;
+	return 1;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* Ports                                                                                */
+/* ---------------------------------------------------------------------------------- */
+
+typedef struct {
+	PORT_t *Regs;
+	uint8_t Out;
+	uint8_t Dir;
+	uint8_t Level;   ///< External level of the input pins (pull-ups: high)
+	uint8_t Flags;
+} HOST_PORT;
+
+static HOST_PORT host_porta = { .Regs = &HostPORTA, .Level = 0xFF };
+static HOST_PORT host_portb = { .Regs = &HostPORTB, .Level = 0xFF };
+
+static void Host_Mt6701Select(HOST_MT6701 *sensor);
+
+static uint8_t Host_PinCtrl(PORT_t *regs, uint8_t pin) {
+	return (&regs->PIN0CTRL)[pin];
+}
+
+static void Host_PortOut(HOST_PORT *port, uint8_t out) {
+	uint8_t falling = port->Out & ~out & port->Dir;
+
+	port->Out = out;
+	if (port == &host_porta) {
+		if (falling & PIN7_bm) Host_Mt6701Select(&HostElevation);
+		if (falling & PIN6_bm) Host_Mt6701Select(&HostAzimuth);
+	}
+}
+
+static void Host_PortDetect(HOST_PORT *port) {
+	PORT_t *regs = port->Regs;
+	uint8_t value;
+
+	if (regs->DIR != port->Dir) port->Dir = regs->DIR;
+	if (regs->OUT != port->Out) Host_PortOut(port, regs->OUT);
+	if (Host_Written(&regs->DIRSET, &value)) port->Dir |= value;
+	if (Host_Written(&regs->DIRCLR, &value)) port->Dir &= ~value;
+	if (Host_Written(&regs->DIRTGL, &value)) port->Dir ^= value;
+	if (Host_Written(&regs->OUTSET, &value)) Host_PortOut(port, port->Out | value);
+	if (Host_Written(&regs->OUTCLR, &value)) Host_PortOut(port, port->Out & ~value);
+	if (Host_Written(&regs->OUTTGL, &value)) Host_PortOut(port, port->Out ^ value);
+	if (Host_Written(&regs->INTFLAGS, &value)) port->Flags &= ~value;
+}
+
+static uint8_t Host_PortIn(HOST_PORT *port) {
+	uint8_t in = (port->Out & port->Dir) | (port->Level & ~port->Dir);
+
+	for (uint8_t pin = 0; pin < 8; pin++) {
+		uint8_t ctrl = Host_PinCtrl(port->Regs, pin);
+		if ((ctrl & PORT_ISC_gm) == PORT_ISC_INPUT_DISABLE_gc) {
+			in &= ~(1 << pin); // Digital input buffer off, reads 0
+		}
+		else if (ctrl & PORT_INVEN_bm) {
+			in ^= 1 << pin;
+		}
+	}
+	return in;
+}
+
+static void Host_PortPublish(HOST_PORT *port) {
+	PORT_t *regs = port->Regs;
+
+	regs->DIR = port->Dir;
+	regs->OUT = port->Out;
+	regs->IN = Host_PortIn(port);
+	regs->INTFLAGS = port->Flags | HOST_UNWRITTEN;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* Timers                                                                               */
+/* ---------------------------------------------------------------------------------- */
+
+static uint8_t host_tcb_on;
+static uint64_t host_tcb_wrap;   ///< Cycle of the last counter wrap (or start)
+static uint64_t host_tcb_next;
+static uint8_t host_tcb_flags;
+
+static uint8_t host_tca_on;
+static uint64_t host_tca_wrap;
+static uint64_t host_tca_next;
+
+static uint32_t Host_TcbDiv(void) {
+	return (HostTCB0.CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_DIV2_gc ? 2 : 1;
+}
+
+static uint64_t Host_TcbPeriod(void) {
+	return ((uint64_t)HostTCB0.CCMP + 1) * Host_TcbDiv();
+}
+
+static uint32_t Host_TcaDiv(void) {
+	static const uint16_t divs[8] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+	return divs[(HostTCA0.SINGLE.CTRLA & TCA_SINGLE_CLKSEL_gm) >> 1];
+}
+
+static uint64_t Host_TcaPeriod(void) {
+	return ((uint64_t)HostTCA0.SINGLE.PER + 1) * Host_TcaDiv();
+}
+
+static void Host_TimerDetect(void) {
+	uint8_t value;
+	uint8_t on = HostTCB0.CTRLA & TCB_ENABLE_bm;
+
+	if (on && !host_tcb_on) {
+		host_tcb_wrap = HostCycles;
+		host_tcb_next = HostCycles + Host_TcbPeriod();
+	}
+	host_tcb_on = on;
+	if (Host_Written(&HostTCB0.INTFLAGS, &value)) host_tcb_flags &= ~value;
+
+	on = HostTCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm;
+	if (on && !host_tca_on) {
+		host_tca_wrap = HostCycles;
+		host_tca_next = HostCycles + Host_TcaPeriod();
+	}
+	host_tca_on = on;
+}
+
+static void Host_TimerPublish(void) {
+	HostTCB0.CNT = host_tcb_on ? (uint16_t)((HostCycles - host_tcb_wrap) / Host_TcbDiv()) : 0;
+	HostTCB0.INTFLAGS = host_tcb_flags | HOST_UNWRITTEN;
+	HostTCA0.SINGLE.CNT = host_tca_on ? (uint16_t)((HostCycles - host_tca_wrap) / Host_TcaDiv()) : 0;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* ADC0                                                                                 */
+/* ---------------------------------------------------------------------------------- */
+
+HOST_ANALOG HostAnalog = {
+	.SolarVoltage = 0.0,
+	.SolarCurrent = 0.0,
+	.CurrentZeroV = 0.048, // 0.12 A at 400 mV/A, the firmware default zero offset (TMCS1100_ZERO_I)
+	.Vdd = 3.3,
+	.NoiseLsb = 0.0
+};
+
+static uint8_t host_adc_busy;
+static uint64_t host_adc_start;
+static uint64_t host_adc_end;
+static uint64_t host_adc_conversion; ///< Cycles per conversion of the running burst
+static uint8_t host_adc_mux;
+static uint8_t host_adc_ref;
+static uint8_t host_adc_shift;
+static uint8_t host_adc_gain;
+static uint8_t host_adc_flags;
+static uint64_t host_noise_state = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Deterministic standard normal random numbers (xorshift64 + Box-Muller).
+ */
+static double Host_Gauss(void) {
+	double u1, u2;
+
+	do {
+		host_noise_state ^= host_noise_state << 13;
+		host_noise_state ^= host_noise_state >> 7;
+		host_noise_state ^= host_noise_state << 17;
+		u1 = (host_noise_state >> 11) * (1.0 / 9007199254740992.0);
+		host_noise_state ^= host_noise_state << 13;
+		host_noise_state ^= host_noise_state >> 7;
+		host_noise_state ^= host_noise_state << 17;
+		u2 = (host_noise_state >> 11) * (1.0 / 9007199254740992.0);
+	} while (u1 <= 0.0);
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double Host_Vdd(double t) {
+	return HostAnalog.VddAt ? HostAnalog.VddAt(t) : HostAnalog.Vdd;
+}
+
+/**
+ * @brief Voltage at an ADC input (AMC1311 on AIN2, TMCS1100 on AIN11, VDD/10).
+ */
+static double Host_AdcInput(uint8_t mux, double t) {
+	double v;
+	double i;
+
+	switch (mux & ADC_MUXPOS_gm) {
+	case ADC_MUXPOS_AIN2_gc:
+		v = HostAnalog.SolarVoltageAt ? HostAnalog.SolarVoltageAt(t) : HostAnalog.SolarVoltage;
+		return v * 2.0 / 300.0;
+	case ADC_MUXPOS_AIN11_gc:
+		i = HostAnalog.SolarCurrentAt ? HostAnalog.SolarCurrentAt(t) : HostAnalog.SolarCurrent;
+		return HostAnalog.CurrentZeroV + i * 0.4;
+	case ADC_MUXPOS_VDDDIV10_gc:
+		return Host_Vdd(t) / 10.0;
+	default:
+		return 0.0;
+	}
+}
+
+static double Host_AdcReference(uint8_t ref, double t) {
+	switch (ref & ADC_REFSEL_gm) {
+	case ADC_REFSEL_1024MV_gc: return 1.024;
+	case ADC_REFSEL_2048MV_gc: return 2.048;
+	case ADC_REFSEL_2500MV_gc: return 2.5;
+	case ADC_REFSEL_4096MV_gc: return 4.096;
+	default: return Host_Vdd(t);
+	}
+}
+
+static void Host_AdcStart(void) {
+	static const uint8_t presc[16] = { 2, 4, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64 };
+
+	if (!(HostADC0.CTRLA & ADC_ENABLE_bm)) {
+		return;
+	}
+	if (host_adc_busy) {
+		host_adc_flags |= ADC_TRIGOVR_bm;
+		return;
+	}
+	host_adc_mux = HostADC0.MUXPOS;
+	host_adc_ref = HostADC0.CTRLC;
+	host_adc_shift = HostADC0.CTRLF & ADC_SAMPNUM_gm;
+	host_adc_gain = ((host_adc_mux & ADC_VIA_gm) == ADC_VIA_PGA_gc && (HostADC0.PGACTRL & ADC_PGAEN_bm))
+		? (HostADC0.PGACTRL & ADC_GAIN_gm) >> ADC_GAIN_gp : 0;
+	host_adc_conversion = (15ULL + HostADC0.CTRLE) * presc[HostADC0.CTRLB & ADC_PRESC_gm];
+	host_adc_start = HostCycles;
+	host_adc_end = HostCycles + (host_adc_conversion << host_adc_shift);
+	host_adc_busy = 1;
+}
+
+/**
+ * @brief End of a burst: accumulates 2^SAMPNUM conversions, each taken at its own time.
+ */
+static void Host_AdcEnd(void) {
+	uint32_t sum = 0;
+	uint16_t sample = 0;
+
+	for (uint32_t n = 0; n < (1UL << host_adc_shift); n++) {
+		double t = (double)(host_adc_start + n * host_adc_conversion) / HOST_F_CPU;
+		double code = Host_AdcInput(host_adc_mux, t) * (1 << host_adc_gain) / Host_AdcReference(host_adc_ref, t) * 4096.0;
+
+		if (HostAnalog.NoiseLsb > 0.0) {
+			code += HostAnalog.NoiseLsb * Host_Gauss();
+		}
+		code = floor(code + 0.5);
+		sample = code < 0.0 ? 0 : code > 4095.0 ? 4095 : (uint16_t)code;
+		sum += sample;
+	}
+	HostADC0.RESULT = sum;
+	HostADC0.SAMPLE = sample;
+	host_adc_flags |= ADC_RESRDY_bm | ADC_SAMPRDY_bm;
+	host_adc_busy = 0;
+	HostAnalog.Bursts++;
+	if (HostAnalog.OnBurst) {
+		HostAnalog.OnBurst(host_adc_mux, host_adc_shift, host_adc_start, HostCycles);
+	}
+}
+
+static void Host_AdcDetect(void) {
+	uint8_t value;
+
+	if (Host_Written(&HostADC0.INTFLAGS, &value)) host_adc_flags &= ~value;
+	if ((HostADC0.COMMAND & ADC_START_gm) == ADC_START_IMMEDIATE_gc) {
+		HostADC0.COMMAND &= ~ADC_START_gm;
+		Host_AdcStart();
+	}
+}
+
+/**
+ * @brief Event channel users of a generator (only TCA0 overflow to the ADC start is routed).
+ */
+static void Host_Event(uint8_t generator) {
+	volatile uint8_t *channels = &HostEVSYS.CHANNEL0;
+
+	for (uint8_t ch = 0; ch < 4; ch++) {
+		if (channels[ch] == generator && HostEVSYS.USERADC0START == ch + 1
+			&& (HostADC0.COMMAND & ADC_START_gm) == ADC_START_EVENT_TRIGGER_gc) {
+			Host_AdcStart();
+		}
+	}
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* MT6701 responders                                                                    */
+/* ---------------------------------------------------------------------------------- */
+
+HOST_MT6701 HostElevation = { .Connected = 1 };
+HOST_MT6701 HostAzimuth = { .Connected = 1 };
+
+uint32_t Host_MT6701Frame(uint16_t code, uint8_t status) {
+	uint32_t data = ((uint32_t)(code & 0x3FFF) << 4) | (status & 0x0F);
+	uint8_t crc = 0;
+
+	for (int8_t bit = 17; bit >= 0; bit--) {
+		uint8_t feedback = ((crc >> 5) ^ (data >> bit)) & 1;
+		crc = (crc << 1) & 0x3F;
+		if (feedback) {
+			crc ^= 0x03; // X^6 + X + 1
+		}
+	}
+	return (data << 6) | crc;
+}
+
+/**
+ * @brief CSN falling edge: the sensor latches its angle and prepares the frame.
+ */
+static void Host_Mt6701Select(HOST_MT6701 *sensor) {
+	double t = Host_Seconds();
+	uint16_t code = (sensor->CodeAt ? sensor->CodeAt(t) : sensor->Code) & 0x3FFF;
+	uint8_t status = (sensor->Field & 0x03) | ((sensor->Button & 1) << 2) | ((sensor->Track & 1) << 3);
+
+	sensor->Frame = Host_MT6701Frame(code, status);
+	if (sensor->CrcErrors) {
+		sensor->Frame ^= 0x01; // Corrupted in transit
+		sensor->CrcErrors--;
+	}
+	sensor->Bit = 0;
+	sensor->Frames++;
+	sensor->LastCode = code;
+	sensor->LastTime = t;
+}
+
+/**
+ * @brief Next 8 bits on the data line, MSB first (pulled up when no sensor drives it).
+ */
+static uint8_t Host_Mt6701Byte(HOST_MT6701 *sensor, uint8_t csn) {
+	uint8_t byte = 0;
+
+	if (!(host_porta.Dir & csn) || (host_porta.Out & csn) || !sensor->Connected) {
+		return 0xFF;
+	}
+	for (uint8_t n = 0; n < 8; n++, sensor->Bit++) {
+		byte <<= 1;
+		if (sensor->Bit < 24) {
+			byte |= (sensor->Frame >> (23 - sensor->Bit)) & 1;
+		}
+	}
+	return byte;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* USART0 (host SPI)                                                                    */
+/* ---------------------------------------------------------------------------------- */
+
+static uint8_t host_u0_full;
+static uint8_t host_u0_data;
+static uint8_t host_u0_shifting;
+static uint64_t host_u0_end;
+static uint8_t host_u0_shift_in;
+static uint8_t host_u0_fifo[2];
+static uint8_t host_u0_count;
+static uint8_t host_u0_presented;
+
+static void Host_Usart0Pop(void) {
+	if (host_u0_count) {
+		host_u0_fifo[0] = host_u0_fifo[1];
+		host_u0_count--;
+	}
+}
+
+static void Host_Usart0Kick(void) {
+	if (host_u0_shifting || !host_u0_full || !(HostUSART0.CTRLB & USART_TXEN_bm)) {
+		return;
+	}
+	if ((HostUSART0.CTRLC & USART_CMODE_gm) != USART_CMODE_MSPI_gc) {
+		Host_Fatal("USART0 is only modelled in host SPI mode");
+	}
+	host_u0_full = 0;
+	host_u0_shifting = 1;
+	host_u0_end = HostCycles + 8ULL * 2 * (HostUSART0.BAUD >> 6);
+	host_u0_shift_in = Host_Mt6701Byte(&HostElevation, PIN7_bm) & Host_Mt6701Byte(&HostAzimuth, PIN6_bm);
+}
+
+static void Host_Usart0End(void) {
+	host_u0_shifting = 0;
+	if (HostUSART0.CTRLB & USART_RXEN_bm) {
+		if (host_u0_count == 2) {
+			HostErrors++; // Receive buffer overflow, the byte is lost
+		}
+		else {
+			host_u0_fifo[host_u0_count++] = host_u0_shift_in;
+		}
+	}
+	Host_Usart0Kick();
+}
+
+static void Host_Usart0Detect(void) {
+	uint8_t value;
+
+	if (Host_Written(&HostUSART0.TXDATAL, &value)) {
+		if (host_u0_full) {
+			HostErrors++; // Written while the transmit buffer was full
+		}
+		host_u0_data = value;
+		host_u0_full = 1;
+		Host_Usart0Kick();
+	}
+	(void)Host_Written(&HostUSART0.STATUS, &value);
+}
+
+static void Host_Usart0Publish(void) {
+	HostUSART0.STATUS = HOST_UNWRITTEN | (host_u0_count ? USART_RXCIF_bm : 0) | (host_u0_full ? 0 : USART_DREIF_bm)
+		| (!host_u0_full && !host_u0_shifting ? USART_TXCIF_bm : 0);
+	HostUSART0.RXDATAL = host_u0_fifo[0];
+	HostUSART0.TXDATAL = HOST_UNWRITTEN;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* USART1 (asynchronous transmitter)                                                    */
+/* ---------------------------------------------------------------------------------- */
+
+static uint8_t host_u1_full;
+static uint8_t host_u1_data;
+static uint8_t host_u1_shifting;
+static uint64_t host_u1_end;
+static uint8_t host_u1_txc;
+static HOST_UART_BYTE *host_u1_capture;
+static size_t host_u1_count;
+static size_t host_u1_size;
+
+uint64_t Host_Uart1ByteCycles(void) {
+	uint32_t samples = (HostUSART1.CTRLB & USART_RXMODE_gm) == USART_RXMODE_CLK2X_gc ? 8 : 16;
+	return (10ULL * HostUSART1.BAUD * samples + 32) / 64; // Start, 8 data and stop bit
+}
+
+static void Host_Usart1Kick(void) {
+	if (host_u1_shifting || !host_u1_full || !(HostUSART1.CTRLB & USART_TXEN_bm)) {
+		return;
+	}
+	if (host_u1_count == host_u1_size) {
+		host_u1_size = host_u1_size ? host_u1_size * 2 : 4096;
+		host_u1_capture = realloc(host_u1_capture, host_u1_size * sizeof(*host_u1_capture));
+		if (!host_u1_capture) {
+			Host_Fatal("out of memory");
+		}
+	}
+	host_u1_capture[host_u1_count].Data = host_u1_data;
+	host_u1_capture[host_u1_count].Start = HostCycles;
+	host_u1_count++;
+	host_u1_full = 0;
+	host_u1_shifting = 1;
+	host_u1_txc = 0;
+	host_u1_end = HostCycles + Host_Uart1ByteCycles();
+}
+
+static void Host_Usart1End(void) {
+	host_u1_shifting = 0;
+	if (host_u1_full) {
+		Host_Usart1Kick();
+	}
+	else {
+		host_u1_txc = 1;
+	}
+}
+
+static void Host_Usart1Detect(void) {
+	uint8_t value;
+
+	if (Host_Written(&HostUSART1.STATUS, &value)) {
+		if (value & USART_TXCIF_bm) host_u1_txc = 0;
+	}
+	if (Host_Written(&HostUSART1.TXDATAL, &value)) {
+		if (host_u1_full) {
+			HostErrors++; // Written while the transmit buffer was full
+		}
+		host_u1_data = value;
+		host_u1_full = 1;
+		Host_Usart1Kick();
+	}
+}
+
+static void Host_Usart1Publish(void) {
+	HostUSART1.STATUS = HOST_UNWRITTEN | (host_u1_full ? 0 : USART_DREIF_bm) | (host_u1_txc ? USART_TXCIF_bm : 0);
+	HostUSART1.TXDATAL = HOST_UNWRITTEN;
+}
+
+size_t Host_Uart1Count(void) {
+	return host_u1_count;
+}
+
+const HOST_UART_BYTE *Host_Uart1Byte(size_t index) {
+	return index < host_u1_count ? &host_u1_capture[index] : NULL;
+}
+
+void Host_Uart1Clear(void) {
+	host_u1_count = 0;
+}
+
+size_t Host_Uart1Frame(size_t *position, uint8_t delimiter, uint8_t *out, size_t size, uint64_t *start) {
+	for (size_t end = *position; end < host_u1_count; end++) {
+		if (host_u1_capture[end].Data == delimiter) {
+			size_t length = end + 1 - *position;
+			for (size_t i = 0; i < length && i < size; i++) {
+				out[i] = host_u1_capture[*position + i].Data;
+			}
+			if (start) {
+				*start = host_u1_capture[*position].Start;
+			}
+			*position = end + 1;
+			return length;
+		}
+	}
+	return 0;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* Test actions                                                                         */
+/* ---------------------------------------------------------------------------------- */
+
+static struct {
+	uint64_t Time;
+	void (*Action)(void);
+} host_actions[HOST_ACTIONS];
+static uint8_t host_action_count;
+
+void Host_At(uint64_t cycles, void (*action)(void)) {
+	if (host_action_count == HOST_ACTIONS) {
+		Host_Fatal("too many scheduled actions");
+	}
+	host_actions[host_action_count].Time = cycles;
+	host_actions[host_action_count].Action = action;
+	host_action_count++;
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* Event loop                                                                           */
+/* ---------------------------------------------------------------------------------- */
+
+static void Host_Publish(void) {
+	Host_PortPublish(&host_porta);
+	Host_PortPublish(&host_portb);
+	Host_TimerPublish();
+	Host_Usart0Publish();
+	Host_Usart1Publish();
+	HostADC0.INTFLAGS = host_adc_flags | HOST_UNWRITTEN;
+	HostCLKCTRL.MCLKSTATUS = 0; // Clock switch done, no change pending
+}
+
+/**
+ * @brief Takes over the register writes the firmware made since the last call.
+ */
+static void Host_Sync(void) {
+	Host_PortDetect(&host_porta);
+	Host_PortDetect(&host_portb);
+	Host_TimerDetect();
+	Host_AdcDetect();
+	Host_Usart0Detect();
+	Host_Usart1Detect();
+	Host_Publish();
+}
+
+static uint64_t Host_NextEvent(void) {
+	uint64_t next = HOST_NEVER;
+
+	if (host_tcb_on && host_tcb_next < next) next = host_tcb_next;
+	if (host_tca_on && host_tca_next < next) next = host_tca_next;
+	if (host_adc_busy && host_adc_end < next) next = host_adc_end;
+	if (host_u0_shifting && host_u0_end < next) next = host_u0_end;
+	if (host_u1_shifting && host_u1_end < next) next = host_u1_end;
+	for (uint8_t i = 0; i < host_action_count; i++) {
+		if (host_actions[i].Time < next) next = host_actions[i].Time;
+	}
+	return next;
+}
+
+/**
+ * @brief Processes every event up to the target time (no interrupt is served).
+ */
+static void Host_AdvanceTo(uint64_t target) {
+	uint64_t next;
+
+	while ((next = Host_NextEvent()) <= target) {
+		if (next > HostCycles) {
+			HostCycles = next;
+		}
+		if (host_tcb_on && host_tcb_next <= HostCycles) {
+			host_tcb_flags |= TCB_CAPT_bm;
+			host_tcb_wrap = host_tcb_next;
+			host_tcb_next += Host_TcbPeriod();
+		}
+		if (host_tca_on && host_tca_next <= HostCycles) {
+			host_tca_wrap = host_tca_next;
+			host_tca_next += Host_TcaPeriod();
+			Host_Event(EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc);
+		}
+		if (host_adc_busy && host_adc_end <= HostCycles) Host_AdcEnd();
+		if (host_u0_shifting && host_u0_end <= HostCycles) Host_Usart0End();
+		if (host_u1_shifting && host_u1_end <= HostCycles) Host_Usart1End();
+		for (uint8_t i = 0; i < host_action_count; i++) {
+			if (host_actions[i].Time <= HostCycles) {
+				void (*action)(void) = host_actions[i].Action;
+				host_actions[i] = host_actions[--host_action_count];
+				action();
+				i = (uint8_t)-1; // Restart, the list changed
+			}
+		}
+		Host_Publish();
+	}
+	if (target > HostCycles) {
+		HostCycles = target;
+	}
+	Host_Publish();
+}
+
+/**
+ * @brief Highest priority pending interrupt (enabled at the peripheral), NULL if none.
+ */
+static void (*Host_Pending(void))(void) {
+	static void (*const unhandled)(void) = (void (*)(void))1;
+
+	if (host_porta.Flags) {
+		return HostVector_PORTA_PORT ? HostVector_PORTA_PORT : unhandled;
+	}
+	if ((host_tcb_flags & TCB_CAPT_bm) && (HostTCB0.INTCTRL & TCB_CAPT_bm)) {
+		return HostVector_TCB0_INT ? HostVector_TCB0_INT : unhandled;
+	}
+	if (host_u0_count && (HostUSART0.CTRLA & USART_RXCIE_bm)) {
+		return HostVector_USART0_RXC ? HostVector_USART0_RXC : unhandled;
+	}
+	if ((host_adc_flags & ADC_RESRDY_bm) && (HostADC0.INTCTRL & ADC_RESRDY_bm)) {
+		return HostVector_ADC0_RESRDY ? HostVector_ADC0_RESRDY : unhandled;
+	}
+	if (!host_u1_full && (HostUSART1.CTRLA & USART_DREIE_bm) && (HostUSART1.CTRLB & USART_TXEN_bm)) {
+		return HostVector_USART1_DRE ? HostVector_USART1_DRE : unhandled;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Serves pending interrupts while the interrupt flag is set.
+ */
+static void Host_Dispatch(void) {
+	uint32_t storm = 0;
+	void (*vector)(void);
+
+	while (HostInterrupts && !host_in_isr && (vector = Host_Pending()) != NULL) {
+		if (vector == (void (*)(void))1) {
+			Host_Fatal("enabled interrupt without a vector");
+		}
+		if (++storm > HOST_ISR_STORM) {
+			Host_Fatal("interrupt flag never cleared");
+		}
+		host_in_isr = 1;
+		HostInterrupts = 0;
+		vector();
+		Host_Sync();
+		if (vector == HostVector_USART0_RXC) {
+			Host_Usart0Pop(); // The ISR has read RXDATAL
+		}
+		host_in_isr = 0;
+		HostInterrupts = 1;
+		Host_Publish();
+	}
+}
+
+void *Host_Access(void *block) {
+	Host_Sync();
+	if (block == &HostUSART0 && !host_in_isr && !(HostUSART0.CTRLA & USART_RXCIE_bm)) {
+		// Polled reads: the byte shown on the previous access counts as read
+		if (host_u0_presented) {
+			Host_Usart0Pop();
+		}
+		host_u0_presented = host_u0_count != 0;
+		Host_Publish();
+	}
+	Host_AdvanceTo(HostCycles + HOST_ACCESS_CYCLES);
+	Host_Dispatch();
+	return block;
+}
+
+void Host_Sei(void) {
+	HostInterrupts = 1; // Pending interrupts are served after the next instruction (next access)
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* Firmware context                                                                     */
+/* ---------------------------------------------------------------------------------- */
+
+static ucontext_t host_context;
+static ucontext_t host_firmware;
+static uint8_t host_started;
+static uint8_t host_in_firmware;
+static uint64_t host_stop;
+
+static void Host_FirmwareEntry(void) {
+	Firmware_Main();
+	Host_Fatal("main() returned");
+}
+
+/**
+ * @brief Returns to the test from the firmware context; continues when Host_Run() is called again.
+ */
+static void Host_Yield(void) {
+	host_in_firmware = 0;
+	swapcontext(&host_firmware, &host_context);
+	host_in_firmware = 1;
+}
+
+void Host_Run(uint32_t us) {
+	host_stop = HostCycles + HOST_US(us);
+	if (!host_started) {
+		getcontext(&host_firmware);
+		host_firmware.uc_stack.ss_sp = malloc(HOST_FIRMWARE_STACK);
+		host_firmware.uc_stack.ss_size = HOST_FIRMWARE_STACK;
+		host_firmware.uc_link = NULL;
+		if (!host_firmware.uc_stack.ss_sp) {
+			Host_Fatal("out of memory");
+		}
+		makecontext(&host_firmware, Host_FirmwareEntry, 0);
+		host_started = 1;
+	}
+	host_in_firmware = 1;
+	swapcontext(&host_context, &host_firmware);
+}
+
+void Host_Sleep(void) {
+	uint64_t start;
+
+	if (!HostSleepEnabled) {
+		return; // SLEEP without SE is a no-op
+	}
+	Host_Sync();
+	start = HostCycles;
+	while (!Host_Pending()) {
+		uint64_t next = Host_NextEvent();
+
+		if (host_in_firmware && HostCycles >= host_stop) {
+			HostSleepCycles += HostCycles - start;
+			Host_Yield();
+			start = HostCycles;
+			continue;
+		}
+		if (next == HOST_NEVER && !host_in_firmware) {
+			Host_Fatal("sleep without a wake-up source");
+		}
+		Host_AdvanceTo(host_in_firmware && next > host_stop ? host_stop : next);
+	}
+	HostSleepCycles += HostCycles - start;
+	Host_Dispatch();
+}
+
+/**
+ * @brief Busy CPU for a number of cycles, interrupts are served as they become pending.
+ */
+static void Host_BusyCycles(uint64_t cycles) {
+	uint64_t target = HostCycles + cycles;
+	uint64_t next;
+
+	Host_Sync();
+	Host_Dispatch();
+	while ((next = Host_NextEvent()) <= target) {
+		Host_AdvanceTo(next);
+		Host_Dispatch();
+	}
+	Host_AdvanceTo(target);
+	Host_Dispatch();
+	if (host_in_firmware && HostCycles >= host_stop) {
+		Host_Yield();
+	}
+}
+
+void Host_Busy(uint32_t us) {
+	Host_BusyCycles(HOST_US(us));
+}
+
+uint64_t Host_Micros(void) {
+	return HostCycles / (HOST_F_CPU / 1000000ULL);
+}
+
+double Host_Seconds(void) {
+	return (double)HostCycles / HOST_F_CPU;
+}
+
+void Host_SetPinA(uint8_t pin, uint8_t level) {
+	uint8_t bit = 1 << pin;
+	uint8_t old = (host_porta.Level & bit) ? 1 : 0;
+	uint8_t isc = Host_PinCtrl(&HostPORTA, pin) & PORT_ISC_gm;
+
+	Host_Sync();
+	level = level ? 1 : 0;
+	if (level) host_porta.Level |= bit;
+	else host_porta.Level &= ~bit;
+	if (!(host_porta.Dir & bit)
+		&& ((isc == PORT_ISC_BOTHEDGES_gc && level != old)
+			|| (isc == PORT_ISC_RISING_gc && level && !old)
+			|| (isc == PORT_ISC_FALLING_gc && !level && old)
+			|| (isc == PORT_ISC_LEVEL_gc && !level))) {
+		host_porta.Flags |= bit;
+	}
+	Host_Publish();
+}
+
+/* ---------------------------------------------------------------------------------- */
+/* EEPROM                                                                               */
+/* ---------------------------------------------------------------------------------- */
+
+extern uint8_t __start_host_eeprom[] __attribute__((weak));
+extern uint8_t __stop_host_eeprom[] __attribute__((weak));
+
+uint32_t HostEepromWrites = 0;
+uint64_t HostEepromLongestWait = 0;
+static uint64_t host_eeprom_busy;
+
+void Host_EepromErase(void) {
+	if (__start_host_eeprom && __stop_host_eeprom) {
+		memset(__start_host_eeprom, 0xFF, __stop_host_eeprom - __start_host_eeprom);
+	}
+}
+
+uint8_t eeprom_is_ready(void) {
+	Host_Access(NULL);
+	return HostCycles >= host_eeprom_busy;
+}
+
+void eeprom_busy_wait(void) {
+	Host_Sync();
+	if (HostCycles < host_eeprom_busy) {
+		Host_BusyCycles(host_eeprom_busy - HostCycles);
+	}
+}
+
+/**
+ * @brief Tracks the longest time a single EEPROM call kept the CPU.
+ */
+static void Host_EepromWaited(uint64_t start) {
+	if (HostCycles - start > HostEepromLongestWait) {
+		HostEepromLongestWait = HostCycles - start;
+	}
+}
+
+void eeprom_read_block(void *destination, const void *source, size_t length) {
+	uint64_t start = HostCycles;
+
+	eeprom_busy_wait();
+	memcpy(destination, source, length);
+	Host_EepromWaited(start);
+}
+
+uint8_t eeprom_read_byte(const uint8_t *address) {
+	uint8_t value;
+	eeprom_read_block(&value, address, 1);
+	return value;
+}
+
+uint16_t eeprom_read_word(const uint16_t *address) {
+	uint16_t value;
+	eeprom_read_block(&value, address, 2);
+	return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t *address) {
+	uint32_t value;
+	eeprom_read_block(&value, address, 4);
+	return value;
+}
+
+static void Host_EepromWrite(uint8_t *address, uint8_t value) {
+	eeprom_busy_wait();
+	*address = value;
+	HostEepromWrites++;
+	host_eeprom_busy = HostCycles + HOST_US(HOST_EEPROM_WRITE_US);
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value) {
+	uint64_t start = HostCycles;
+	Host_EepromWrite(address, value);
+	Host_EepromWaited(start);
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value) {
+	uint64_t start = HostCycles;
+
+	eeprom_busy_wait();
+	if (*address != value) {
+		Host_EepromWrite(address, value);
+	}
+	Host_EepromWaited(start);
+}
+
+void eeprom_write_block(const void *source, void *destination, size_t length) {
+	uint64_t start = HostCycles;
+
+	for (size_t i = 0; i < length; i++) {
+		Host_EepromWrite((uint8_t *)destination + i, ((const uint8_t *)source)[i]);
+	}
+	Host_EepromWaited(start);
+}
+
+void eeprom_update_block(const void *source, void *destination, size_t length) {
+	uint64_t start = HostCycles;
+
+	for (size_t i = 0; i < length; i++) {
+		uint8_t value = ((const uint8_t *)source)[i];
+		if (((uint8_t *)destination)[i] != value) {
+			Host_EepromWrite((uint8_t *)destination + i, value);
+		}
+	}
+	Host_EepromWaited(start);
+}
+
+/**
+ * @brief Reset state: erased EEPROM and USERROW, reset values of the published registers.
+ */
+__attribute__((constructor)) static void Host_Reset(void) {
+	volatile uint16_t *strobes[] = {
+		&HostPORTA.DIRSET, &HostPORTA.DIRCLR, &HostPORTA.DIRTGL, &HostPORTA.OUTSET, &HostPORTA.OUTCLR, &HostPORTA.OUTTGL,
+		&HostPORTB.DIRSET, &HostPORTB.DIRCLR, &HostPORTB.DIRTGL, &HostPORTB.OUTSET, &HostPORTB.OUTCLR, &HostPORTB.OUTTGL
+	};
+
+	for (size_t i = 0; i < sizeof(strobes) / sizeof(strobes[0]); i++) {
+		*strobes[i] = HOST_UNWRITTEN;
+	}
+	Host_EepromErase();
+	memset((void *)&HostUSERROW, 0xFF, sizeof(HostUSERROW));
+	Host_Publish();
+}
@@ -0,0 +1,213 @@
+/**
+ * @file Host.h
+ * @brief Host models of the ATtiny1624 peripherals used by the firmware.
+ *
+ * The firmware sources are compiled unchanged against the headers in test/mock. Every
+ * peripheral access goes through Host_Access(), which keeps the register blocks in step
+ * with a virtual clock and the behavioral models:
+ *
+ * - CPU: interrupt enable flag, interrupt dispatch in vector order, idle sleep.
+ * - TCB0: periodic interrupt mode, CNT follows the virtual clock.
+ * - TCA0 + EVSYS + ADC0: overflow events start accumulated bursts on the selected input;
+ *   the samples come from the analog signal models in HostAnalog.
+ * - USART0: host SPI (MSPI) with double-buffered transmitter and 2-byte receive FIFO,
+ *   clocking bits out of the MT6701 responders selected by their CSN pins.
+ * - USART1: asynchronous transmitter whose bytes are captured with their start time.
+ * - PORTA: end switch inputs with pin change interrupts.
+ * - EEPROM: EEMEM variables are the EEPROM cells (erased to 0xFF), writes take
+ *   HOST_EEPROM_WRITE_US each.
+ * - USERROW: HostUSERROW, erased to 0xFF; tests program it before the firmware starts.
+ *
+ * Firmware code takes no virtual time by itself: time passes while the CPU sleeps,
+ * busy-waits (_delay_x, EEPROM writes, Host_Busy()) and HOST_ACCESS_CYCLES per
+ * peripheral access. The USART0 model supports interrupt-driven transfers
+ * (SSI_USE_INTERRUPT 1); polled transfers cannot be told from register reads.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief CPU clock of the virtual time base (cycles per second).
+ */
+#define HOST_F_CPU 20000000ULL
+
+/**
+ * @brief CPU cycles charged for every peripheral register access.
+ */
+#define HOST_ACCESS_CYCLES 2
+
+/**
+ * @brief Time one EEPROM byte write keeps the EEPROM busy, in microseconds.
+ */
+#define HOST_EEPROM_WRITE_US 4000
+
+/**
+ * @brief Converts microseconds to CPU cycles.
+ */
+#define HOST_US(us) ((uint64_t)(us) * (HOST_F_CPU / 1000000ULL))
+
+/**
+ * @brief Global interrupt enable (SREG I bit) and sleep state, used by the mock headers.
+ */
+extern uint8_t HostInterrupts;
+extern uint8_t HostSleepEnabled;
+extern uint8_t HostSleepMode;
+
+/**
+ * @brief Virtual time in CPU cycles since reset.
+ */
+extern uint64_t HostCycles;
+
+/**
+ * @brief Cycles the CPU spent in sleep instructions.
+ */
+extern uint64_t HostSleepCycles;
+
+/**
+ * @brief Synchronizes the models and returns a register block (see the mock <avr/io.h>).
+ */
+void *Host_Access(void *block);
+
+/**
+ * @brief Sets the interrupt enable flag and serves pending interrupts (SEI).
+ */
+void Host_Sei(void);
+
+/**
+ * @brief Sleeps until the next interrupt (SLEEP instruction).
+ */
+void Host_Sleep(void);
+
+/**
+ * @brief Busy CPU for the given time: the clock runs and interrupts are served.
+ */
+void Host_Busy(uint32_t us);
+
+/**
+ * @brief Runs the firmware for the given virtual time.
+ *
+ * The first call starts main() (initialization and scheduler) on its own stack, later
+ * calls continue the firmware where it stopped. Returns at the first sleep or busy-wait
+ * after the time has passed.
+ */
+void Host_Run(uint32_t us);
+
+/**
+ * @brief Schedules an action at an absolute virtual time (hardware context, e.g. a pin change).
+ */
+void Host_At(uint64_t cycles, void (*action)(void));
+
+/**
+ * @brief Current virtual time.
+ */
+uint64_t Host_Micros(void);
+double Host_Seconds(void);
+
+/**
+ * @brief Model errors (firmware misuse of a peripheral, e.g. a USART data register overrun).
+ */
+extern uint32_t HostErrors;
+
+/**
+ * @brief One byte captured on the USART1 line.
+ */
+typedef struct {
+	uint8_t Data;   ///< Byte value
+	uint64_t Start; ///< Cycle at which its start bit began
+} HOST_UART_BYTE;
+
+/**
+ * @brief USART1 line capture.
+ */
+size_t Host_Uart1Count(void);
+const HOST_UART_BYTE *Host_Uart1Byte(size_t index);
+void Host_Uart1Clear(void);
+
+/**
+ * @brief Cycles one byte (start, 8 data, stop bit) takes on the USART1 line.
+ */
+uint64_t Host_Uart1ByteCycles(void);
+
+/**
+ * @brief Returns the next captured frame ending with a delimiter byte.
+ *
+ * @param position Capture index to start from, advanced past the frame.
+ * @param delimiter Last byte of a frame ('\n' for ASCII, 0x00 for COBS).
+ * @param out Frame bytes, delimiter included (truncated to size).
+ * @param size Size of out.
+ * @param start Receives the start cycle of the first byte (may be NULL).
+ * @return Frame length, 0 if no complete frame is left.
+ */
+size_t Host_Uart1Frame(size_t *position, uint8_t delimiter, uint8_t *out, size_t size, uint64_t *start);
+
+/**
+ * @brief MT6701 SSI responder behind one CSN pin.
+ */
+typedef struct {
+	uint8_t Connected;                 ///< 0 = no sensor, the data line stays pulled up
+	uint16_t Code;                     ///< 14-bit angle code (used when CodeAt is NULL)
+	uint16_t (*CodeAt)(double seconds); ///< Optional angle code trajectory
+	uint8_t Field;                     ///< Magnetic field status bits (0 = normal)
+	uint8_t Button;                    ///< Push button bit
+	uint8_t Track;                     ///< 1 = loss of track
+	uint16_t CrcErrors;                ///< Number of next frames sent with a corrupted CRC
+	uint32_t Frames;                   ///< Frames started (CSN falling edges)
+	uint16_t LastCode;                 ///< Angle code of the last frame
+	double LastTime;                   ///< Time of the last CSN falling edge, seconds
+	uint32_t Frame;                    ///< Latched 24-bit frame (internal)
+	uint8_t Bit;                       ///< Bits already clocked out (internal)
+} HOST_MT6701;
+
+extern HOST_MT6701 HostElevation; ///< CSN on PA7
+extern HOST_MT6701 HostAzimuth;   ///< CSN on PA6
+
+/**
+ * @brief MT6701 SSI frame: 14-bit angle, 4 status bits, CRC-6 (X^6 + X + 1).
+ */
+uint32_t Host_MT6701Frame(uint16_t code, uint8_t status);
+
+/**
+ * @brief Analog signal models sampled by the ADC.
+ *
+ * Functions, when set, override the constant values. NoiseLsb is the rms noise of a
+ * single conversion in LSB (deterministic pseudo-random sequence).
+ */
+typedef struct {
+	double SolarVoltage;              ///< String voltage, V (AMC1311 path, 300 V = 2 V)
+	double SolarCurrent;              ///< String current, A (TMCS1100, 400 mV/A)
+	double CurrentZeroV;              ///< TMCS1100 output at zero current, V
+	double Vdd;                       ///< Supply voltage, V
+	double NoiseLsb;                  ///< Conversion noise, LSB rms
+	double (*SolarVoltageAt)(double seconds);
+	double (*SolarCurrentAt)(double seconds);
+	double (*VddAt)(double seconds);
+	void (*OnBurst)(uint8_t muxpos, uint8_t shift, uint64_t start, uint64_t end); ///< Called after every burst
+	uint32_t Bursts;                  ///< Completed bursts
+} HOST_ANALOG;
+
+extern HOST_ANALOG HostAnalog;
+
+/**
+ * @brief Drives a PORTA input pin (1 = high) and raises its pin change interrupt.
+ */
+void Host_SetPinA(uint8_t pin, uint8_t level);
+
+/**
+ * @brief EEPROM model statistics.
+ */
+extern uint32_t HostEepromWrites;    ///< Bytes written
+extern uint64_t HostEepromLongestWait; ///< Longest busy-wait of a single EEPROM call, cycles
+
+/**
+ * @brief Sets every EEMEM cell to the erased value 0xFF (done at start-up).
+ */
+void Host_EepromErase(void);
+
+#endif /* HOST_H_ */
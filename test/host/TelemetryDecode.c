@@ -0,0 +1,138 @@
+/**
+ * @file TelemetryDecode.c
+ * @brief Receiver side of the telemetry frames: ASCII parser, COBS decoder and field unpacker.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "TelemetryDecode.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Packs the ASCII frame fields like the firmware: E[15:0] A[15:0] V[11:0] C[11:0] Y[3:0].
+ */
+static void Decode_PackFields(const TelemetryFrame *frame, uint8_t *fields) {
+	fields[0] = frame->Elevation >> 12;
+	fields[1] = frame->Elevation >> 4;
+	fields[2] = (frame->Elevation << 4) | (frame->Azimuth >> 12);
+	fields[3] = frame->Azimuth >> 4;
+	fields[4] = (frame->Azimuth << 4) | (frame->Voltage >> 8);
+	fields[5] = frame->Voltage;
+	fields[6] = frame->Current >> 4;
+	fields[7] = (frame->Current << 4) | frame->EndSwitches;
+}
+
+uint8_t Decode_Ascii(const uint8_t *text, size_t length, TelemetryFrame *frame) {
+	unsigned e, a, v, c, y, crc;
+	char buffer[TELEMETRY_ASCII_FRAME + 1];
+	uint8_t fields[TELEMETRY_FIELD_BYTES];
+
+	if (length != TELEMETRY_ASCII_FRAME || text[length - 2] != '\r' || text[length - 1] != '\n') {
+		return 0;
+	}
+	memcpy(buffer, text, length);
+	buffer[length] = 0;
+	if (sscanf(buffer, "<%4x%4x%3x%3x%1x%2x>", &e, &a, &v, &c, &y, &crc) != 6) {
+		return 0;
+	}
+	memset(frame, 0, sizeof(*frame));
+	frame->Elevation = e;
+	frame->Azimuth = a;
+	frame->Voltage = v;
+	frame->Current = c;
+	frame->EndSwitches = y;
+	Decode_PackFields(frame, fields);
+	return crc == Decode_Crc8(fields, sizeof(fields));
+}
+
+int Decode_AsciiRaw(const uint8_t *text, size_t length, char start, uint8_t *out) {
+	size_t bytes;
+
+	if (length < 5 || text[0] != (uint8_t)start || text[length - 2] != '\r' || text[length - 1] != '\n'
+		|| (length - 3) % 2) {
+		return -1;
+	}
+	bytes = (length - 3) / 2;
+	for (size_t i = 0; i < bytes; i++) {
+		unsigned value;
+		char digits[3] = { text[1 + 2 * i], text[2 + 2 * i], 0 };
+
+		if (sscanf(digits, "%2x", &value) != 1) {
+			return -1;
+		}
+		out[i] = value;
+	}
+	return Decode_Crc8(out, bytes - 1) == out[bytes - 1] ? (int)bytes : -1;
+}
+
+int Decode_Cobs(const uint8_t *in, size_t length, uint8_t *out) {
+	size_t in_index = 0;
+	size_t out_index = 0;
+
+	if (length && in[length - 1] == 0x00) {
+		length--; // Frame delimiter
+	}
+	while (in_index < length) {
+		uint8_t code = in[in_index++];
+
+		if (code == 0x00 || in_index + code - 1 > length) {
+			return -1;
+		}
+		for (uint8_t i = 1; i < code; i++) {
+			if (in[in_index] == 0x00) {
+				return -1;
+			}
+			out[out_index++] = in[in_index++];
+		}
+		if (code != 0xFF && in_index < length) {
+			out[out_index++] = 0x00; // A block shorter than 254 ends at a zero byte
+		}
+	}
+	return (int)out_index;
+}
+
+uint8_t Decode_Crc8(const uint8_t *data, size_t length) {
+	uint8_t crc = 0xFF;
+
+	while (length--) {
+		crc ^= *data++;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x9B) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+/**
+ * @brief Big-endian 16-bit value.
+ */
+static uint16_t Decode_Be16(const uint8_t *data) {
+	return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+uint8_t Decode_Binary(const uint8_t *payload, size_t length, TelemetryFrame *frame, uint8_t *sequence) {
+	const uint8_t *fields = &payload[1];
+	const uint8_t *extension = &payload[1 + TELEMETRY_FIELD_BYTES];
+
+	if (length != TELEMETRY_BINARY_PAYLOAD || payload[0] != 6) {
+		return 0;
+	}
+	if (Decode_Crc8(&payload[1], length - 2) != payload[length - 1]) {
+		return 0;
+	}
+	frame->Elevation = Decode_Be16(&fields[0]) << 4 | fields[2] >> 4;
+	frame->Azimuth = (fields[2] & 0x0F) << 12 | Decode_Be16(&fields[3]) >> 4;
+	frame->Voltage = Decode_Be16(&fields[4]) & 0x0FFF;
+	frame->Current = Decode_Be16(&fields[6]) >> 4;
+	frame->EndSwitches = fields[7] & 0x0F;
+	frame->Status = extension[0];
+	if (sequence) {
+		*sequence = extension[1];
+	}
+	frame->ElevationVelocity = (int16_t)Decode_Be16(&extension[2]);
+	frame->AzimuthVelocity = (int16_t)Decode_Be16(&extension[4]);
+	frame->Energy = (uint32_t)Decode_Be16(&extension[6]) << 16 | Decode_Be16(&extension[8]);
+	frame->AzimuthTurns = (int16_t)Decode_Be16(&extension[10]);
+	return 1;
+}
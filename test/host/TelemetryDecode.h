@@ -0,0 +1,67 @@
+/**
+ * @file TelemetryDecode.h
+ * @brief Receiver side of the telemetry frames: ASCII parser, COBS decoder and field unpacker.
+ *
+ * Written from the frame description in Telemetry.c, independently of the firmware
+ * serializer, so that round trips check the layout and not only self-consistency.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef TELEMETRYDECODE_H_
+#define TELEMETRYDECODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Telemetry.h"
+
+/**
+ * @brief Parses an ASCII telemetry frame `<EEEEAAAAVVVCCCYXX>\r\n`.
+ *
+ * @param text Frame bytes, "\r\n" included.
+ * @param length Number of bytes (TELEMETRY_ASCII_FRAME).
+ * @param frame Receives elevation, azimuth, voltage, current and end switches.
+ * @return 1 if the frame is well formed and its CRC-8 matches, 0 otherwise.
+ */
+uint8_t Decode_Ascii(const uint8_t *text, size_t length, TelemetryFrame *frame);
+
+/**
+ * @brief Parses an ASCII raw frame: start character, bytes in hex and "\r\n".
+ *
+ * @param text Frame bytes.
+ * @param length Number of bytes.
+ * @param start Expected start character.
+ * @param out Decoded bytes, at least (length - 3) / 2 bytes.
+ * @return Number of decoded bytes, -1 if the frame is malformed or its CRC-8 (last byte) does not match.
+ */
+int Decode_AsciiRaw(const uint8_t *text, size_t length, char start, uint8_t *out);
+
+/**
+ * @brief Decodes one COBS frame.
+ *
+ * @param in Encoded bytes, with or without the trailing 0x00 delimiter.
+ * @param length Number of encoded bytes.
+ * @param out Decoded bytes, at least length bytes.
+ * @return Number of decoded bytes, -1 if the frame is malformed (zero byte inside the
+ *         frame or a code byte pointing past its end).
+ */
+int Decode_Cobs(const uint8_t *in, size_t length, uint8_t *out);
+
+/**
+ * @brief Unpacks a decoded version 6 binary telemetry frame.
+ *
+ * @param payload Decoded frame bytes.
+ * @param length Number of decoded bytes (TELEMETRY_BINARY_PAYLOAD).
+ * @param frame Receives the field values.
+ * @param sequence Receives the sequence number (may be NULL).
+ * @return 1 if the length, version and CRC-8 match, 0 otherwise.
+ */
+uint8_t Decode_Binary(const uint8_t *payload, size_t length, TelemetryFrame *frame, uint8_t *sequence);
+
+/**
+ * @brief CRC-8/CDMA2000 (poly 0x9B, init 0xFF, no reflection, no final XOR), bitwise.
+ */
+uint8_t Decode_Crc8(const uint8_t *data, size_t length);
+
+#endif /* TELEMETRYDECODE_H_ */
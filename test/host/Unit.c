@@ -0,0 +1,54 @@
+/**
+ * @file Unit.c
+ * @brief Minimal test runner for the host tests.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include "Unit.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+unsigned UnitFailures = 0;
+
+static unsigned unit_cases;
+static unsigned unit_failed;
+
+void Unit_Fail(const char *file, int line, const char *message) {
+	fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message);
+	UnitFailures++;
+}
+
+void Unit_Case(const char *name, void (*test)(void)) {
+	int status = 0;
+	pid_t pid;
+
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid == 0) {
+		alarm(UNIT_TIMEOUT_S);
+		test();
+		fflush(stdout);
+		_exit(UnitFailures ? 1 : 0);
+	}
+	unit_cases++;
+	if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+		unit_failed++;
+		if (pid > 0 && WIFSIGNALED(status)) {
+			printf("FAIL %s (signal %d)\n", name, WTERMSIG(status));
+		}
+		else {
+			printf("FAIL %s\n", name);
+		}
+	}
+	else {
+		printf("ok   %s\n", name);
+	}
+}
+
+int Unit_Finish(void) {
+	printf("%u of %u cases passed\n", unit_cases - unit_failed, unit_cases);
+	return unit_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
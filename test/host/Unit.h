@@ -0,0 +1,59 @@
+/**
+ * @file Unit.h
+ * @brief Minimal test runner for the host tests.
+ *
+ * Each case runs in its own process, so every case starts from the reset state of the
+ * firmware and the models. A failed check prints its location and fails the case.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef UNIT_H_
+#define UNIT_H_
+
+#include <stdio.h>
+
+/**
+ * @brief Time limit of one case in seconds (wall clock).
+ */
+#define UNIT_TIMEOUT_S 120
+
+extern unsigned UnitFailures;
+
+void Unit_Fail(const char *file, int line, const char *message);
+
+#define UNIT_CHECK(condition) \
+	do { if (!(condition)) Unit_Fail(__FILE__, __LINE__, #condition); } while (0)
+
+#define UNIT_EQUAL(actual, expected) \
+	do { \
+		long long unit_a_ = (long long)(actual), unit_e_ = (long long)(expected); \
+		if (unit_a_ != unit_e_) { \
+			char unit_m_[256]; \
+			snprintf(unit_m_, sizeof(unit_m_), "%s == %lld, expected %s == %lld", #actual, unit_a_, #expected, unit_e_); \
+			Unit_Fail(__FILE__, __LINE__, unit_m_); \
+		} \
+	} while (0)
+
+#define UNIT_NEAR(actual, expected, tolerance) \
+	do { \
+		double unit_a_ = (double)(actual), unit_e_ = (double)(expected); \
+		if (!(unit_a_ >= unit_e_ - (tolerance) && unit_a_ <= unit_e_ + (tolerance))) { \
+			char unit_m_[256]; \
+			snprintf(unit_m_, sizeof(unit_m_), "%s == %g, expected %g +/- %g", #actual, unit_a_, unit_e_, (double)(tolerance)); \
+			Unit_Fail(__FILE__, __LINE__, unit_m_); \
+		} \
+	} while (0)
+
+/**
+ * @brief Runs one case in a child process and reports the result.
+ */
+void Unit_Case(const char *name, void (*test)(void));
+
+/**
+ * @brief Prints the summary, returns the process exit code.
+ */
+int Unit_Finish(void);
+
+#endif /* UNIT_H_ */
@@ -0,0 +1,23 @@
+/**
+ * @file cpufunc.h
+ * @brief Host replacement of <avr/cpufunc.h>.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_AVR_CPUFUNC_H_
+#define HOST_AVR_CPUFUNC_H_
+
+#include <stdint.h>
+
+#define _NOP() ((void)0)
+#define _MemoryBarrier() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Configuration change protected write (no protection on the host).
+ */
+static inline void ccp_write_io(void *address, uint8_t value) {
+	*(volatile uint8_t *)address = value;
+}
+
+#endif /* HOST_AVR_CPUFUNC_H_ */
@@ -0,0 +1,33 @@
+/**
+ * @file eeprom.h
+ * @brief Host replacement of <avr/eeprom.h>.
+ *
+ * EEMEM variables are the EEPROM cells: they live in their own section, which the
+ * model erases to 0xFF before the firmware starts. Every changed byte keeps the EEPROM
+ * busy for HOST_EEPROM_WRITE_US; the functions wait for it like avr-libc does.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Host.h"
+
+#define EEMEM __attribute__((section("host_eeprom"), used))
+
+uint8_t eeprom_is_ready(void);
+void eeprom_busy_wait(void);
+uint8_t eeprom_read_byte(const uint8_t *address);
+uint16_t eeprom_read_word(const uint16_t *address);
+uint32_t eeprom_read_dword(const uint32_t *address);
+void eeprom_read_block(void *destination, const void *source, size_t length);
+void eeprom_write_byte(uint8_t *address, uint8_t value);
+void eeprom_update_byte(uint8_t *address, uint8_t value);
+void eeprom_write_block(const void *source, void *destination, size_t length);
+void eeprom_update_block(const void *source, void *destination, size_t length);
+
+#endif /* HOST_AVR_EEPROM_H_ */
@@ -0,0 +1,21 @@
+/**
+ * @file interrupt.h
+ * @brief Host replacement of <avr/interrupt.h>: global interrupt flag and ISR definitions.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include "Host.h"
+
+#define sei() Host_Sei()
+#define cli() (HostInterrupts = 0)
+
+/**
+ * @brief Interrupt service routine, dispatched by the host models in vector order.
+ */
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,386 @@
+/**
+ * @file io.h
+ * @brief Host replacement of <avr/io.h> for the ATtiny1624 peripherals used by the firmware.
+ *
+ * Register blocks keep the member names of the device header. Every use of a block name
+ * (PORTA, ADC0, ...) goes through Host_Access(), which advances the virtual clock and
+ * updates the models (test/host/Host.c).
+ *
+ * Strobe and write-1-to-clear registers (DIRSET, OUTSET, INTFLAGS, TXDATAL, ...) are 16 bits
+ * wide here and read back with HOST_UNWRITTEN set, so any 8-bit write by the firmware can
+ * be told from the published value. Bit positions and group codes are those of the device.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+#include "Host.h"
+
+#define HOST_UNWRITTEN 0x100 ///< Set in strobe registers until the firmware writes them
+
+typedef volatile uint8_t register8_t;
+typedef volatile uint16_t register16_t;
+typedef volatile uint32_t register32_t;
+
+#define _BV(bit) (1 << (bit))
+
+/* PORT */
+typedef struct {
+	register8_t DIR;
+	register16_t DIRSET;
+	register16_t DIRCLR;
+	register16_t DIRTGL;
+	register8_t OUT;
+	register16_t OUTSET;
+	register16_t OUTCLR;
+	register16_t OUTTGL;
+	register8_t IN;
+	register16_t INTFLAGS;
+	register8_t PORTCTRL;
+	register8_t PIN0CTRL;
+	register8_t PIN1CTRL;
+	register8_t PIN2CTRL;
+	register8_t PIN3CTRL;
+	register8_t PIN4CTRL;
+	register8_t PIN5CTRL;
+	register8_t PIN6CTRL;
+	register8_t PIN7CTRL;
+} PORT_t;
+
+#define PIN0_bm 0x01
+#define PIN1_bm 0x02
+#define PIN2_bm 0x04
+#define PIN3_bm 0x08
+#define PIN4_bm 0x10
+#define PIN5_bm 0x20
+#define PIN6_bm 0x40
+#define PIN7_bm 0x80
+
+#define PORT_ISC_gm 0x07
+#define PORT_ISC_INTDISABLE_gc 0x00
+#define PORT_ISC_BOTHEDGES_gc 0x01
+#define PORT_ISC_RISING_gc 0x02
+#define PORT_ISC_FALLING_gc 0x03
+#define PORT_ISC_INPUT_DISABLE_gc 0x04
+#define PORT_ISC_LEVEL_gc 0x05
+#define PORT_PULLUPEN_bm 0x08
+#define PORT_INVEN_bm 0x80
+
+/* PORTMUX */
+typedef struct {
+	register8_t EVSYSROUTEA;
+	register8_t CCLROUTEA;
+	register8_t USARTROUTEA;
+	register8_t SPIROUTEA;
+	register8_t TCAROUTEA;
+	register8_t TCBROUTEA;
+} PORTMUX_t;
+
+#define PORTMUX_USART0_DEFAULT_gc 0x00
+#define PORTMUX_USART0_ALT1_gc 0x01
+#define PORTMUX_USART1_DEFAULT_gc 0x00
+#define PORTMUX_USART1_ALT1_gc 0x04
+
+/* CLKCTRL */
+typedef struct {
+	register8_t MCLKCTRLA;
+	register8_t MCLKCTRLB;
+	register8_t MCLKLOCK;
+	register8_t MCLKSTATUS;
+	register8_t OSC20MCTRLA;
+	register8_t OSC20MCALIBA;
+	register8_t OSC20MCALIBB;
+	register8_t OSC32KCTRLA;
+	register8_t XOSC32KCTRLA;
+} CLKCTRL_t;
+
+#define CLKCTRL_CLKSEL_gm 0x03
+#define CLKCTRL_CLKSEL_OSC20M_gc 0x00
+#define CLKCTRL_CLKSEL_OSCULP32K_gc 0x01
+#define CLKCTRL_CLKSEL_XOSC32K_gc 0x02
+#define CLKCTRL_CLKSEL_EXTCLK_gc 0x03
+#define CLKCTRL_CLKOUT_bm 0x80
+#define CLKCTRL_PEN_bm 0x01
+#define CLKCTRL_PDIV_gm 0x1E
+#define CLKCTRL_PDIV_2X_gc 0x00
+#define CLKCTRL_SOSC_bm 0x01
+#define CLKCTRL_OSC20MS_bm 0x10
+#define CLKCTRL_OSC32KS_bm 0x20
+#define CLKCTRL_XOSC32KS_bm 0x40
+#define CLKCTRL_EXTS_bm 0x80
+
+/* SLPCTRL (used through <avr/sleep.h>) */
+#define SLPCTRL_SMODE_gm 0x06
+#define SLPCTRL_SMODE_IDLE_gc 0x00
+#define SLPCTRL_SMODE_STDBY_gc 0x02
+#define SLPCTRL_SMODE_PDOWN_gc 0x04
+#define SLPCTRL_SEN_bm 0x01
+
+/* EVSYS */
+typedef struct {
+	register8_t CHANNEL0;
+	register8_t CHANNEL1;
+	register8_t CHANNEL2;
+	register8_t CHANNEL3;
+	register8_t USERADC0START;
+	register8_t USERTCB0CAPT;
+	register8_t USERUSART0IRDA;
+	register8_t USERUSART1IRDA;
+} EVSYS_t;
+
+#define EVSYS_CHANNEL0_OFF_gc 0x00
+#define EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc 0x80
+#define EVSYS_USER_OFF_gc 0x00
+#define EVSYS_USER_CHANNEL0_gc 0x01
+#define EVSYS_USER_CHANNEL1_gc 0x02
+
+/* TCA0 (single-slope mode only) */
+typedef struct {
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t CTRLC;
+	register8_t CTRLD;
+	register8_t EVCTRL;
+	register8_t INTCTRL;
+	register8_t INTFLAGS;
+	register16_t CNT;
+	register16_t PER;
+	register16_t CMP0;
+	register16_t CMP1;
+	register16_t CMP2;
+} TCA_SINGLE_t;
+
+typedef struct {
+	TCA_SINGLE_t SINGLE;
+} TCA_t;
+
+#define TCA_SINGLE_ENABLE_bm 0x01
+#define TCA_SINGLE_CLKSEL_gm 0x0E
+#define TCA_SINGLE_CLKSEL_DIV1_gc 0x00
+#define TCA_SINGLE_CLKSEL_DIV2_gc 0x02
+#define TCA_SINGLE_CLKSEL_DIV4_gc 0x04
+#define TCA_SINGLE_CLKSEL_DIV8_gc 0x06
+#define TCA_SINGLE_CLKSEL_DIV16_gc 0x08
+#define TCA_SINGLE_CLKSEL_DIV64_gc 0x0A
+#define TCA_SINGLE_CLKSEL_DIV256_gc 0x0C
+#define TCA_SINGLE_CLKSEL_DIV1024_gc 0x0E
+#define TCA_SINGLE_WGMODE_gm 0x07
+#define TCA_SINGLE_WGMODE_NORMAL_gc 0x00
+
+/* TCB0 */
+typedef struct {
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t EVCTRL;
+	register8_t INTCTRL;
+	register16_t INTFLAGS;
+	register8_t STATUS;
+	register8_t DBGCTRL;
+	register8_t TEMP;
+	register16_t CNT;
+	register16_t CCMP;
+} TCB_t;
+
+#define TCB_ENABLE_bm 0x01
+#define TCB_CLKSEL_gm 0x0E
+#define TCB_CLKSEL_DIV1_gc 0x00
+#define TCB_CLKSEL_DIV2_gc 0x02
+#define TCB_CLKSEL_TCA0_gc 0x04
+#define TCB_CLKSEL_EVENT_gc 0x0E
+#define TCB_CNTMODE_gm 0x07
+#define TCB_CNTMODE_INT_gc 0x00
+#define TCB_CAPT_bm 0x01
+#define TCB_OVF_bm 0x02
+
+/* USART */
+typedef struct {
+	register8_t RXDATAL;
+	register8_t RXDATAH;
+	register16_t TXDATAL;
+	register8_t TXDATAH;
+	register16_t STATUS;
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t CTRLC;
+	register16_t BAUD;
+	register8_t CTRLD;
+	register8_t DBGCTRL;
+	register8_t EVCTRL;
+	register8_t TXPLCTRL;
+	register8_t RXPLCTRL;
+} USART_t;
+
+#define USART_RXCIF_bm 0x80
+#define USART_TXCIF_bm 0x40
+#define USART_DREIF_bm 0x20
+#define USART_RXSIF_bm 0x10
+#define USART_ISFIF_bm 0x08
+#define USART_BDF_bm 0x02
+#define USART_WFB_bm 0x01
+#define USART_RXCIE_bm 0x80
+#define USART_TXCIE_bm 0x40
+#define USART_DREIE_bm 0x20
+#define USART_RXSIE_bm 0x10
+#define USART_LBME_bm 0x08
+#define USART_ABEIE_bm 0x04
+#define USART_RXEN_bm 0x80
+#define USART_TXEN_bm 0x40
+#define USART_SFDEN_bm 0x10
+#define USART_ODME_bm 0x08
+#define USART_RXMODE_gm 0x06
+#define USART_RXMODE_NORMAL_gc 0x00
+#define USART_RXMODE_CLK2X_gc 0x02
+#define USART_MPCM_bm 0x01
+#define USART_CMODE_gm 0xC0
+#define USART_CMODE_ASYNCHRONOUS_gc 0x00
+#define USART_CMODE_SYNCHRONOUS_gc 0x40
+#define USART_CMODE_IRCOM_gc 0x80
+#define USART_CMODE_MSPI_gc 0xC0
+#define USART_PMODE_gm 0x30
+#define USART_PMODE_DISABLED_gc 0x00
+#define USART_PMODE_EVEN_gc 0x20
+#define USART_PMODE_ODD_gc 0x30
+#define USART_SBMODE_1BIT_gc 0x00
+#define USART_SBMODE_2BIT_gc 0x08
+#define USART_CHSIZE_gm 0x07
+#define USART_CHSIZE_8BIT_gc 0x03
+#define USART_UDORD_bm 0x04
+#define USART_UCPHA_bm 0x02
+
+/* ADC0 */
+typedef struct {
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t CTRLC;
+	register8_t CTRLD;
+	register8_t CTRLE;
+	register8_t CTRLF;
+	register8_t COMMAND;
+	register8_t EVCTRL;
+	register8_t INTCTRL;
+	register16_t INTFLAGS;
+	register8_t DBGCTRL;
+	register8_t TEMP;
+	register32_t RESULT;
+	register16_t SAMPLE;
+	register8_t MUXPOS;
+	register8_t MUXNEG;
+	register8_t PGACTRL;
+} ADC_t;
+
+#define ADC_ENABLE_bm 0x01
+#define ADC_LOWLAT_bm 0x20
+#define ADC_RUNSTDBY_bm 0x80
+#define ADC_PRESC_gm 0x0F
+#define ADC_PRESC_DIV2_gc 0x00
+#define ADC_PRESC_DIV4_gc 0x01
+#define ADC_PRESC_DIV6_gc 0x02
+#define ADC_PRESC_DIV8_gc 0x03
+#define ADC_PRESC_DIV10_gc 0x04
+#define ADC_PRESC_DIV12_gc 0x05
+#define ADC_PRESC_DIV14_gc 0x06
+#define ADC_PRESC_DIV16_gc 0x07
+#define ADC_PRESC_DIV20_gc 0x08
+#define ADC_PRESC_DIV24_gc 0x09
+#define ADC_PRESC_DIV28_gc 0x0A
+#define ADC_PRESC_DIV32_gc 0x0B
+#define ADC_PRESC_DIV40_gc 0x0C
+#define ADC_PRESC_DIV48_gc 0x0D
+#define ADC_PRESC_DIV56_gc 0x0E
+#define ADC_PRESC_DIV64_gc 0x0F
+#define ADC_REFSEL_gm 0x07
+#define ADC_REFSEL_VDD_gc 0x00
+#define ADC_REFSEL_VREFA_gc 0x02
+#define ADC_REFSEL_1024MV_gc 0x04
+#define ADC_REFSEL_2048MV_gc 0x05
+#define ADC_REFSEL_2500MV_gc 0x06
+#define ADC_REFSEL_4096MV_gc 0x07
+#define ADC_TIMEBASE_gm 0xF8
+#define ADC_TIMEBASE_gp 3
+#define ADC_SAMPNUM_gm 0x0F
+#define ADC_SAMPNUM_gp 0
+#define ADC_LEFTADJ_bm 0x10
+#define ADC_FREERUN_bm 0x20
+#define ADC_START_gm 0x07
+#define ADC_START_STOP_gc 0x00
+#define ADC_START_IMMEDIATE_gc 0x01
+#define ADC_START_EVENT_TRIGGER_gc 0x04
+#define ADC_MODE_gm 0x70
+#define ADC_MODE_SINGLE_8BIT_gc 0x00
+#define ADC_MODE_SINGLE_12BIT_gc 0x10
+#define ADC_MODE_SERIES_gc 0x20
+#define ADC_MODE_SERIES_SCALING_gc 0x30
+#define ADC_MODE_BURST_gc 0x40
+#define ADC_MODE_BURST_SCALING_gc 0x50
+#define ADC_RESRDY_bm 0x01
+#define ADC_SAMPRDY_bm 0x02
+#define ADC_WCMP_bm 0x04
+#define ADC_RESOVR_bm 0x08
+#define ADC_SAMPOVR_bm 0x10
+#define ADC_TRIGOVR_bm 0x20
+#define ADC_MUXPOS_gm 0x3F
+#define ADC_MUXPOS_AIN1_gc 0x01
+#define ADC_MUXPOS_AIN2_gc 0x02
+#define ADC_MUXPOS_AIN3_gc 0x03
+#define ADC_MUXPOS_AIN11_gc 0x0B
+#define ADC_MUXPOS_GND_gc 0x30
+#define ADC_MUXPOS_VDDDIV10_gc 0x31
+#define ADC_MUXPOS_TEMPSENSE_gc 0x32
+#define ADC_MUXPOS_DACREF0_gc 0x33
+#define ADC_VIA_gm 0xC0
+#define ADC_VIA_ADC_gc 0x00
+#define ADC_VIA_PGA_gc 0x40
+#define ADC_PGAEN_bm 0x01
+#define ADC_PGABIASSEL_gm 0x06
+#define ADC_GAIN_gm 0xE0
+#define ADC_GAIN_gp 5
+#define ADC_GAIN_1X_gc 0x00
+#define ADC_GAIN_2X_gc 0x20
+#define ADC_GAIN_4X_gc 0x40
+#define ADC_GAIN_8X_gc 0x60
+#define ADC_GAIN_16X_gc 0x80
+
+/* USERROW (mapped in data space, survives a chip erase) */
+typedef struct {
+	register8_t USERROW0[32]; ///< USERROW0 .. USERROW31 of the device header as one array
+} USERROW_t;
+
+#define USER_SIGNATURES_SIZE 32
+
+/* Register blocks, owned by the models in Host.c */
+extern PORT_t HostPORTA;
+extern PORT_t HostPORTB;
+extern PORTMUX_t HostPORTMUX;
+extern CLKCTRL_t HostCLKCTRL;
+extern EVSYS_t HostEVSYS;
+extern TCA_t HostTCA0;
+extern TCB_t HostTCB0;
+extern USART_t HostUSART0;
+extern USART_t HostUSART1;
+extern ADC_t HostADC0;
+extern USERROW_t HostUSERROW;
+
+#define PORTA (*(PORT_t *)Host_Access((void *)&HostPORTA))
+#define PORTB (*(PORT_t *)Host_Access((void *)&HostPORTB))
+#define PORTMUX (*(PORTMUX_t *)Host_Access((void *)&HostPORTMUX))
+#define CLKCTRL (*(CLKCTRL_t *)Host_Access((void *)&HostCLKCTRL))
+#define EVSYS (*(EVSYS_t *)Host_Access((void *)&HostEVSYS))
+#define TCA0 (*(TCA_t *)Host_Access((void *)&HostTCA0))
+#define TCB0 (*(TCB_t *)Host_Access((void *)&HostTCB0))
+#define USART0 (*(USART_t *)Host_Access((void *)&HostUSART0))
+#define USART1 (*(USART_t *)Host_Access((void *)&HostUSART1))
+#define ADC0 (*(ADC_t *)Host_Access((void *)&HostADC0))
+#define USERROW (*(USERROW_t *)Host_Access((void *)&HostUSERROW))
+
+/* Interrupt vectors, in priority order (lowest vector number first) */
+#define PORTA_PORT_vect HostVector_PORTA_PORT
+#define TCB0_INT_vect HostVector_TCB0_INT
+#define USART0_RXC_vect HostVector_USART0_RXC
+#define ADC0_RESRDY_vect HostVector_ADC0_RESRDY
+#define USART1_DRE_vect HostVector_USART1_DRE
+
+#endif /* HOST_AVR_IO_H_ */
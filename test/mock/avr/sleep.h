@@ -0,0 +1,19 @@
+/**
+ * @file sleep.h
+ * @brief Host replacement of <avr/sleep.h>: the CPU sleeps in virtual time until an interrupt.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+#include "Host.h"
+
+#define set_sleep_mode(mode) (HostSleepMode = (mode))
+#define sleep_enable() (HostSleepEnabled = 1)
+#define sleep_disable() (HostSleepEnabled = 0)
+#define sleep_cpu() Host_Sleep()
+#define sleep_mode() do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#endif /* HOST_AVR_SLEEP_H_ */
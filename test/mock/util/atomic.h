@@ -0,0 +1,37 @@
+/**
+ * @file atomic.h
+ * @brief Host replacement of <util/atomic.h>, same construction as avr-libc.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_
+
+#include <stdint.h>
+#include "Host.h"
+
+static inline uint8_t Host_AtomicStart(void) {
+	HostInterrupts = 0;
+	return 1;
+}
+
+static inline void Host_AtomicRestore(const uint8_t *state) {
+	if (*state) {
+		Host_Sei();
+	}
+	else {
+		HostInterrupts = 0;
+	}
+}
+
+static inline void Host_AtomicForceOn(const uint8_t *state) {
+	(void)state;
+	Host_Sei();
+}
+
+#define ATOMIC_BLOCK(type) for (type, __ToDo = Host_AtomicStart(); __ToDo; __ToDo = 0)
+#define ATOMIC_RESTORESTATE uint8_t sreg_save __attribute__((__cleanup__(Host_AtomicRestore))) = HostInterrupts
+#define ATOMIC_FORCEON uint8_t sreg_save __attribute__((__cleanup__(Host_AtomicForceOn))) = 0
+
+#endif /* HOST_UTIL_ATOMIC_H_ */
@@ -0,0 +1,16 @@
+/**
+ * @file delay.h
+ * @brief Host replacement of <util/delay.h>: busy-waits in virtual time.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "Host.h"
+
+#define _delay_us(us) Host_Busy((uint32_t)(us))
+#define _delay_ms(ms) Host_Busy((uint32_t)((ms) * 1000))
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,98 @@
+/**
+ * @file CalibrationRecord.c
+ * @brief Calibration record builder and Intel HEX writer.
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "CalibrationRecord.h"
+
+void CalibrationRecord_Defaults(CalibrationValues *values) {
+	values->VoltageGain = 1.0;
+	values->VoltageOffset = 0.0;
+	values->CurrentGain = 1.0;
+	values->CurrentZero = TMCS1100_ZERO_I / 100.0;
+	values->ElevationZero = 0.0;
+	values->AzimuthZero = 0.0;
+	values->Flags = (MT6701_ELEVATION_REVERSED ? CALIBRATION_ELEVATION_REVERSED : 0)
+		| (MT6701_AZIMUTH_REVERSED ? CALIBRATION_AZIMUTH_REVERSED : 0);
+}
+
+/**
+ * @brief Rounds a gain to Q1.15.
+ *
+ * @return 1 if it fits (0 to 0xFFFF), 0 otherwise.
+ */
+static uint8_t CalibrationRecord_Gain(double gain, uint16_t *q15) {
+	long value = lround(gain * CALIBRATION_GAIN_ONE);
+
+	if (!(gain >= 0) || value > 0xFFFF) {
+		return 0;
+	}
+	*q15 = value;
+	return 1;
+}
+
+/**
+ * @brief Angle zero in 0.01 degree, wrapped to 0 .. MT6701_FULL_TURN - 1.
+ */
+static uint16_t CalibrationRecord_Angle(double degrees) {
+	long value = lround(fmod(degrees, 360.0) * 100) % MT6701_FULL_TURN;
+
+	return value < 0 ? value + MT6701_FULL_TURN : value;
+}
+
+static uint8_t *CalibrationRecord_Put16(uint8_t *out, uint16_t value) {
+	*out++ = value & 0xFF;
+	*out++ = value >> 8;
+	return out;
+}
+
+const char *CalibrationRecord_Build(const CalibrationValues *values, uint8_t *record) {
+	uint16_t voltageGain;
+	uint16_t currentGain;
+	long voltageOffset = lround(values->VoltageOffset * 10);
+	long currentZero = lround(values->CurrentZero * 100);
+	uint8_t *out = record;
+	uint8_t crc = CRC8_CDMA2000_INIT;
+
+	if (!CalibrationRecord_Gain(values->VoltageGain, &voltageGain)) {
+		return "voltage gain must be 0 to 1.99997";
+	}
+	if (!CalibrationRecord_Gain(values->CurrentGain, &currentGain)) {
+		return "current gain must be 0 to 1.99997";
+	}
+	if (voltageOffset < INT16_MIN || voltageOffset > INT16_MAX) {
+		return "voltage offset must be -3276.8 to 3276.7 V";
+	}
+	if (currentZero < 0 || currentZero > UINT16_MAX) {
+		return "current zero must be 0 to 655.35 A";
+	}
+	*out++ = CALIBRATION_VERSION;
+	out = CalibrationRecord_Put16(out, voltageGain);
+	out = CalibrationRecord_Put16(out, (uint16_t)(int16_t)voltageOffset);
+	out = CalibrationRecord_Put16(out, currentGain);
+	out = CalibrationRecord_Put16(out, currentZero);
+	out = CalibrationRecord_Put16(out, CalibrationRecord_Angle(values->ElevationZero));
+	out = CalibrationRecord_Put16(out, CalibrationRecord_Angle(values->AzimuthZero));
+	*out++ = values->Flags;
+	for (uint8_t *data = record; data < out; data++) {
+		crc = crc8_cdma2000_update(crc, *data);
+	}
+	*out = crc8_cdma2000_final(crc);
+	return NULL;
+}
+
+size_t CalibrationRecord_Hex(const uint8_t *record, uint16_t address, char *text, size_t size) {
+	uint8_t sum = sizeof(CALIBRATION_RECORD) + (address >> 8) + (address & 0xFF); // Type 00: data
+	int length = snprintf(text, size, ":%02X%04X00", (unsigned)sizeof(CALIBRATION_RECORD), address);
+
+	for (size_t i = 0; i < sizeof(CALIBRATION_RECORD); i++) {
+		length += snprintf(text + length, size - length, "%02X", record[i]);
+		sum += record[i];
+	}
+	length += snprintf(text + length, size - length, "%02X\n:00000001FF\n", (uint8_t)-sum);
+	return length;
+}
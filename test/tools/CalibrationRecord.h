@@ -0,0 +1,59 @@
+/**
+ * @file CalibrationRecord.h
+ * @brief Builds the per-unit calibration record from measured values, and its Intel HEX image.
+ *
+ * The record layout is CALIBRATION_RECORD from Calibration.h: little-endian fields,
+ * packed to 15 bytes, CRC-8/CDMA2000 over the first 14.
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#ifndef CALIBRATIONRECORD_H_
+#define CALIBRATIONRECORD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Settings.h"
+
+/**
+ * @brief Calibration in physical units.
+ */
+typedef struct {
+	double VoltageGain;   ///< Factor applied to the voltage, 0 to below 2.0
+	double VoltageOffset; ///< Added to the voltage, V
+	double CurrentGain;   ///< Factor applied to the current, 0 to below 2.0
+	double CurrentZero;   ///< Current sensor zero offset, A
+	double ElevationZero; ///< Elevation angle zero, degree
+	double AzimuthZero;   ///< Azimuth angle zero, degree
+	uint8_t Flags;        ///< CALIBRATION_x flags
+} CalibrationValues;
+
+/**
+ * @brief Values giving the same results as the compile-time defaults.
+ *
+ * @param values Receives unity gains, no offsets, the default current zero and directions.
+ */
+void CalibrationRecord_Defaults(CalibrationValues *values);
+
+/**
+ * @brief Converts the values to a record and appends version and CRC-8.
+ *
+ * @param values Calibration in physical units.
+ * @param record Receives the sizeof(CALIBRATION_RECORD) record bytes.
+ * @return NULL on success, otherwise a message naming the value out of range.
+ */
+const char *CalibrationRecord_Build(const CalibrationValues *values, uint8_t *record);
+
+/**
+ * @brief Writes the record as Intel HEX: one data record at the address and the end record.
+ *
+ * @param record Record bytes.
+ * @param address Offset in the USERROW (CALIBRATION_USERROW_OFFSET).
+ * @param text Receives the zero terminated HEX text.
+ * @param size Size of text, at least 64 bytes.
+ * @return Length of the text.
+ */
+size_t CalibrationRecord_Hex(const uint8_t *record, uint16_t address, char *text, size_t size);
+
+#endif /* CALIBRATIONRECORD_H_ */
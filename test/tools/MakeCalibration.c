@@ -0,0 +1,81 @@
+/**
+ * @file MakeCalibration.c
+ * @brief Writes a calibration record as Intel HEX for programming the USERROW over UPDI.
+ *
+ * Usage: MakeCalibration [name=value]...
+ *
+ *   voltage-gain=1.0       Factor applied to the voltage (0 to 1.99997)
+ *   voltage-offset=0.0     Added to the voltage, V
+ *   current-gain=1.0       Factor applied to the current (0 to 1.99997)
+ *   current-zero=0.12      Current sensor zero offset, A
+ *   elevation-zero=0.0     Elevation angle zero, degree
+ *   azimuth-zero=0.0       Azimuth angle zero, degree
+ *   elevation-reversed=1   Elevation reported as 360 degree - angle
+ *   azimuth-reversed=1     Azimuth reported as 360 degree - angle
+ *   auto-zero=0            Measure the current sensor zero at start-up
+ *
+ * Omitted values give the compile-time defaults. The record is placed at
+ * CALIBRATION_USERROW_OFFSET of the USERROW, where the firmware reads it. Example:
+ *
+ *   MakeCalibration voltage-gain=1.0123 current-zero=0.14 > calibration.hex
+ *   avrdude -c serialupdi -P /dev/ttyUSB0 -p t1624 -U userrow:w:calibration.hex:i
+ *
+ * @author Saulius
+ * @date 2025-06-20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CalibrationRecord.h"
+
+/**
+ * @brief Sets or clears a flag from a 0/1 value.
+ */
+static void SetFlag(uint8_t *flags, uint8_t flag, const char *value) {
+	if (strtol(value, NULL, 0)) {
+		*flags |= flag;
+	}
+	else {
+		*flags &= ~flag;
+	}
+}
+
+int main(int argc, char **argv) {
+	CalibrationValues values;
+	uint8_t record[sizeof(CALIBRATION_RECORD)];
+	char text[128];
+	const char *error;
+
+	CalibrationRecord_Defaults(&values);
+	for (int i = 1; i < argc; i++) {
+		char *value = strchr(argv[i], '=');
+
+		if (!value) {
+			fprintf(stderr, "%s: expected name=value, got \"%s\"\n", argv[0], argv[i]);
+			return 2;
+		}
+		*value++ = '\0';
+		if (!strcmp(argv[i], "voltage-gain")) values.VoltageGain = atof(value);
+		else if (!strcmp(argv[i], "voltage-offset")) values.VoltageOffset = atof(value);
+		else if (!strcmp(argv[i], "current-gain")) values.CurrentGain = atof(value);
+		else if (!strcmp(argv[i], "current-zero")) values.CurrentZero = atof(value);
+		else if (!strcmp(argv[i], "elevation-zero")) values.ElevationZero = atof(value);
+		else if (!strcmp(argv[i], "azimuth-zero")) values.AzimuthZero = atof(value);
+		else if (!strcmp(argv[i], "elevation-reversed")) SetFlag(&values.Flags, CALIBRATION_ELEVATION_REVERSED, value);
+		else if (!strcmp(argv[i], "azimuth-reversed")) SetFlag(&values.Flags, CALIBRATION_AZIMUTH_REVERSED, value);
+		else if (!strcmp(argv[i], "auto-zero")) SetFlag(&values.Flags, CALIBRATION_AUTO_ZERO, value);
+		else {
+			fprintf(stderr, "%s: unknown value \"%s\"\n", argv[0], argv[i]);
+			return 2;
+		}
+	}
+	error = CalibrationRecord_Build(&values, record);
+	if (error) {
+		fprintf(stderr, "%s: %s\n", argv[0], error);
+		return 1;
+	}
+	CalibrationRecord_Hex(record, CALIBRATION_USERROW_OFFSET, text, sizeof(text));
+	fputs(text, stdout);
+	return 0;
+}